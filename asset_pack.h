@@ -0,0 +1,217 @@
+/**
+ * @file asset_pack.h
+ * @brief Packed asset archive shared by the game and the maze_packer tool
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The archive (assets.pak) holds every asset the game needs at start-up in a
+ * single file. Images are stored already decoded as native-endian ARGB8888
+ * pixels; wall textures are stored pre-scaled in the engine's texture layout
+ * so the game can point at the mapped pixels directly. Fonts and sounds are
+ * stored as the original file bytes and opened through SDL_RWops.
+ *
+ * Layout: AssetPackHeader, entryCount AssetPackEntry records, then the entry
+ * payloads, each aligned to ASSET_PACK_ALIGNMENT bytes.
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <SDL2/SDL.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+const char ASSET_PACK_MAGIC[4] = {'M', 'S', 'P', 'K'};
+const Uint32 ASSET_PACK_VERSION = 2;
+const Uint32 ASSET_PACK_BYTE_ORDER = 0x01020304;  // Pixels are native-endian
+const Uint32 ASSET_PACK_ALIGNMENT = 64;
+const char* const ASSET_PACK_FILE = "assets.pak";
+
+// Asset manifest, shared so the packer writes exactly what the game reads
+const int WALL_TEXTURE_COUNT = 7;
+const char* const WALL_TEXTURE_FILES[WALL_TEXTURE_COUNT] = {
+    "textures/wall1.png",    // Brick wall
+    "textures/wall2.png",    // Stone wall
+    "textures/wall3.png",    // Blue wall
+    "textures/wall4.png",    // White wall
+    "textures/wall5.png",    // Wood wall
+    "textures/wall6.png",    // Green wall
+    "textures/wall7.png"     // Purple wall
+};
+
+const int GUN_SPRITE_COUNT = 4;
+const char* const GUN_SPRITE_FILES[GUN_SPRITE_COUNT] = {
+    "gun/gun_idle.png",   // Frame 0 - Idle
+    "gun/gun_fire1.png",  // Frame 1 - Fire frame 1
+    "gun/gun_fire2.png",  // Frame 2 - Fire frame 2
+    "gun/gun_fire3.png"   // Frame 3 - Fire frame 3
+};
+
+const char* const MENU_BACKGROUND_FILE = "menu.jpg";
+const char* const FONT_FILE = "fonts/font.ttf";
+const char* const SHOOT_SOUND_FILE = "sounds/shoot.wav";
+
+enum AssetType {
+    ASSET_PIXELS = 1,  // width * height ARGB8888 pixels, tightly packed
+    ASSET_BLOB = 2     // Raw file bytes
+};
+
+struct AssetPackHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 byteOrder;
+    Uint32 entryCount;
+    Uint32 reserved[4];
+};
+
+struct AssetPackEntry {
+    char name[48];   // Original asset path, NUL terminated
+    Uint32 type;     // AssetType
+    Uint32 width;    // Pixel entries only
+    Uint32 height;
+    Uint32 reserved;
+    Uint64 offset;   // From the start of the file
+    Uint64 size;     // In bytes
+};
+
+static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader layout");
+static_assert(sizeof(AssetPackEntry) == 80, "AssetPackEntry layout");
+
+/**
+ * Read-only view of an asset archive. The file is memory-mapped, so entry
+ * data stays valid (and is shared with the page cache) until close().
+ */
+class AssetPack {
+private:
+    const Uint8* data;
+    size_t dataSize;
+    const AssetPackHeader* header;
+    const AssetPackEntry* entries;
+#ifdef _WIN32
+    std::vector<Uint8> fileData;
+#endif
+
+public:
+    AssetPack() : data(nullptr), dataSize(0), header(nullptr), entries(nullptr) {}
+
+    ~AssetPack() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(AssetPackHeader)) {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map " << path << std::endl;
+            return false;
+        }
+        data = (const Uint8*)mapped;
+        dataSize = st.st_size;
+#else
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (fileData.size() < sizeof(AssetPackHeader)) {
+            fileData.clear();
+            return false;
+        }
+        data = fileData.data();
+        dataSize = fileData.size();
+#endif
+
+        header = (const AssetPackHeader*)data;
+        if (memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 ||
+            header->version != ASSET_PACK_VERSION ||
+            header->byteOrder != ASSET_PACK_BYTE_ORDER) {
+            std::cerr << path << " is not a compatible asset pack (rebuild it with 'make pack')" << std::endl;
+            close();
+            return false;
+        }
+        size_t tableEnd = sizeof(AssetPackHeader) + (size_t)header->entryCount * sizeof(AssetPackEntry);
+        if (tableEnd > dataSize) {
+            std::cerr << path << " is truncated" << std::endl;
+            close();
+            return false;
+        }
+        entries = (const AssetPackEntry*)(data + sizeof(AssetPackHeader));
+        for (Uint32 i = 0; i < header->entryCount; i++) {
+            // Written so that a huge offset or size cannot wrap around
+            if (entries[i].offset > dataSize || entries[i].size > dataSize - entries[i].offset) {
+                std::cerr << path << " is truncated" << std::endl;
+                close();
+                return false;
+            }
+            if (!memchr(entries[i].name, '\0', sizeof(entries[i].name)) ||
+                (entries[i].type == ASSET_PIXELS &&
+                 entries[i].size != (Uint64)entries[i].width * entries[i].height * sizeof(Uint32))) {
+                std::cerr << path << " has a corrupt entry " << i << std::endl;
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (data) {
+            munmap((void*)data, dataSize);
+        }
+#else
+        fileData.clear();
+#endif
+        data = nullptr;
+        dataSize = 0;
+        header = nullptr;
+        entries = nullptr;
+    }
+
+    bool isOpen() const {
+        return data != nullptr;
+    }
+
+    const AssetPackEntry* find(const std::string& name, AssetType type) const {
+        if (!isOpen()) return nullptr;
+
+        for (Uint32 i = 0; i < header->entryCount; i++) {
+            if (entries[i].type == (Uint32)type && name == entries[i].name) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const void* entryData(const AssetPackEntry* entry) const {
+        return data + entry->offset;
+    }
+};
+
+#endif // ASSET_PACK_H
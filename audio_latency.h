@@ -0,0 +1,174 @@
+/**
+ * @file audio_latency.h
+ * @brief Audio underrun detection and shot-to-sound latency measurement
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * AudioMonitor hooks SDL_mixer's post-mix callback. Each callback produces
+ * one buffer of audio; if more wall time has passed since the device opened
+ * than the audio produced so far plus one buffer of slack, the device ran
+ * dry (an underrun) and the deficit is forgiven so it is counted once.
+ *
+ * LatencyProbe timestamps, for one shot at a time, the keypress, the first
+ * mixer callback that mixes the shot sound (a per-channel effect, or the
+ * voice mixer's start notification), and the
+ * present of the first frame showing gun_fire1. The mixed buffer is heard
+ * roughly one buffer later, which the report includes as an estimate.
+ */
+
+#ifndef AUDIO_LATENCY_H
+#define AUDIO_LATENCY_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <iostream>
+
+inline double ticksToMs(Uint64 ticks) {
+    return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+class AudioMonitor {
+private:
+    std::atomic<Uint32> underruns;
+    Uint64 bufferTicks;      // Performance counter ticks per mixed buffer
+    Uint64 startTicks;       // Audio thread only, from here on
+    Uint64 producedTicks;
+
+    static void postMix(void* udata, Uint8* stream, int len) {
+        (void)stream;
+        (void)len;
+        AudioMonitor* monitor = (AudioMonitor*)udata;
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        if (monitor->startTicks == 0) {
+            monitor->startTicks = now;
+        }
+        Uint64 elapsed = now - monitor->startTicks;
+        if (elapsed > monitor->producedTicks + monitor->bufferTicks) {
+            monitor->underruns++;
+            monitor->startTicks = now - monitor->producedTicks;
+        }
+        monitor->producedTicks += monitor->bufferTicks;
+    }
+
+public:
+    AudioMonitor() : underruns(0), bufferTicks(0), startTicks(0), producedTicks(0) {}
+
+    // Call right after the device is opened; replaces any post-mix hook
+    void install(int frequency, int bufferFrames) {
+        Mix_SetPostMix(nullptr, nullptr);
+        bufferTicks = SDL_GetPerformanceFrequency() * bufferFrames / frequency;
+        startTicks = 0;
+        producedTicks = 0;
+        underruns = 0;
+        Mix_SetPostMix(postMix, this);
+    }
+
+    // Underruns since the last call
+    Uint32 takeUnderruns() {
+        return underruns.exchange(0);
+    }
+};
+
+class LatencyProbe {
+private:
+    Uint64 bufferTicks;
+    Uint64 keyTime;
+    std::atomic<Uint64> mixedTime;   // Written by the audio thread
+    std::atomic<int> probeChannel;
+    std::atomic<Uint32> probeVoice;
+    Uint64 frameTime;
+    bool waiting;
+
+    // Totals for the summary
+    int shots;
+    double mixedSum;
+    double frameSum;
+
+    static void firstMix(int channel, void* stream, int len, void* udata) {
+        (void)stream;
+        (void)len;
+        LatencyProbe* probe = (LatencyProbe*)udata;
+        if (channel != probe->probeChannel) return;  // An earlier shot still playing
+        Uint64 expected = 0;
+        probe->mixedTime.compare_exchange_strong(expected, SDL_GetPerformanceCounter());
+    }
+
+    // One shot at a time; give up on one that never reached the screen
+    bool arm(Uint64 keyTicks) {
+        if (waiting && keyTicks - keyTime < SDL_GetPerformanceFrequency()) return false;
+        keyTime = keyTicks;
+        mixedTime = 0;
+        frameTime = 0;
+        waiting = true;
+        return true;
+    }
+
+    void report() {
+        double mixedMs = ticksToMs(mixedTime - keyTime);
+        double audibleMs = ticksToMs(mixedTime - keyTime + bufferTicks);
+        double frameMs = ticksToMs(frameTime - keyTime);
+        std::cout << "Shot latency: sound mixed +" << mixedMs << " ms (heard ~+" << audibleMs
+                  << " ms), gun_fire1 presented +" << frameMs << " ms, sound "
+                  << (audibleMs >= frameMs ? "lags" : "leads") << " picture by ~"
+                  << (audibleMs >= frameMs ? audibleMs - frameMs : frameMs - audibleMs) << " ms" << std::endl;
+        shots++;
+        mixedSum += mixedMs;
+        frameSum += frameMs;
+        waiting = false;
+    }
+
+public:
+    LatencyProbe() : bufferTicks(0), keyTime(0), mixedTime(0), probeChannel(-1), probeVoice(0),
+                     frameTime(0), waiting(false),
+                     shots(0), mixedSum(0), frameSum(0) {}
+
+    void setBuffer(int frequency, int bufferFrames) {
+        bufferTicks = SDL_GetPerformanceFrequency() * bufferFrames / frequency;
+    }
+
+    // Shoot key handled and the sound started on channel (-1 if it failed)
+    void onShoot(Uint64 keyTicks, int channel) {
+        if (channel < 0 || !arm(keyTicks)) return;
+        probeChannel = channel;
+        probeVoice = 0;
+        // Effects are dropped by SDL_mixer when the channel finishes
+        Mix_RegisterEffect(channel, firstMix, nullptr, this);
+    }
+
+    // Same, for a sound started on the voice mixer (handle 0 if it failed)
+    void onShootVoice(Uint64 keyTicks, Uint32 handle) {
+        if (handle == 0 || !arm(keyTicks)) return;
+        probeChannel = -1;
+        probeVoice = handle;
+    }
+
+    // VoiceMixer start listener; voices start in the callback that first mixes them
+    static void voiceStarted(Uint32 handle, void* udata) {
+        LatencyProbe* probe = (LatencyProbe*)udata;
+        if (handle != probe->probeVoice) return;
+        Uint64 expected = 0;
+        probe->mixedTime.compare_exchange_strong(expected, SDL_GetPerformanceCounter());
+    }
+
+    void onFramePresented(int gunFrame) {
+        if (!waiting) return;
+        if (frameTime == 0 && gunFrame == 1) {
+            frameTime = SDL_GetPerformanceCounter();
+        }
+        if (frameTime != 0 && mixedTime != 0) {
+            report();
+        }
+    }
+
+    void printSummary() const {
+        if (shots == 0) return;
+        std::cout << "Latency over " << shots << " shots: sound mixed +" << mixedSum / shots
+                  << " ms (heard ~+" << mixedSum / shots + ticksToMs(bufferTicks) << " ms), gun_fire1 presented +"
+                  << frameSum / shots << " ms" << std::endl;
+    }
+};
+
+#endif // AUDIO_LATENCY_H
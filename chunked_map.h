@@ -0,0 +1,570 @@
+/**
+ * @file chunked_map.h
+ * @brief World grid split into 64x64 chunks, streamed from disk on demand
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The engine reads the world through ChunkedMap. Chunks are 64x64 one-byte
+ * cells (4 KB, column-major inside the chunk) and live in a fixed pool of
+ * resident slots. Next to the cells, each chunk keeps a derived occupancy
+ * bitmap: one bit per cell (set = wall), tiled as 8x8 blocks of one
+ * uint64_t each. A ray crossing the chunk in any direction touches at most
+ * a few blocks (512 bytes for the whole chunk), so the DDA's hit test
+ * stays in L1 and the cell byte is read only once a wall is found. That
+ * pays off once the map outgrows the caches; a map small enough to stay
+ * cached walks faster on the bytes. So maps of at least
+ * MIN_BITMAP_TEST_CELLS cells test the bitmap and smaller ones the bytes.
+ *
+ * The bitmap doubles as an occupancy pyramid for empty-space skipping: a
+ * zero block word is an empty 8x8 square, and a chunk whose words are all
+ * zero is an empty 64x64 square. In chunks with at least
+ * MIN_SPARSE_CHUNK_BLOCKS empty blocks, a leaping cursor's emptyShift()
+ * reports the largest such square around a cell and castRay() leaps
+ * across it. Leaping only pays off in maps that are mostly open, so it is
+ * decided once per map, when it is loaded: rays leap only if at least
+ * MIN_LEAPING_SPARSE_CHUNK_PERCENT of the chunks are sparse, and
+ * otherwise walk cell by cell without any leap test (see withRayView()).
+ *
+ * A flat table with one pointer per chunk maps chunk coordinates to slot
+ * memory (nullptr when not resident), so finding a chunk is one array
+ * index and raycasts only consult the table when they cross into another
+ * chunk (see ChunkedMap::Cursor).
+ *
+ * Small maps (GameMap) are copied in whole with every chunk resident.
+ * Large maps are opened from a .msc file and streamed:
+ *
+ *   4096-byte ChunkedMapHeader (sparseChunks counted by write(); 0 in
+ *   older files, whose rays then never leap)
+ *   chunksX * chunksY chunks of 4096 bytes, chunk (cx, cy) at index
+ *   cx * chunksY + cy; cells past the map edge are walls
+ *
+ * prefetch() runs once per frame. It keeps the chunks around the player
+ * and along the view frustum resident, loading a bounded number per
+ * frame. A chunk that is still missing when a ray reaches it is read
+ * synchronously. When the pool is full, the least recently used slot is
+ * evicted. A 16k x 16k map is a 256 MB file; the default pool is 4.5 MB.
+ *
+ * Anything outside the map reads as a solid wall chunk.
+ */
+
+#ifndef CHUNKED_MAP_H
+#define CHUNKED_MAP_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "map.h"
+
+const int CHUNK_SHIFT = 6;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_MASK = CHUNK_SIZE - 1;
+const int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+const int BLOCK_SHIFT = 3;
+const int BLOCK_SIZE = 1 << BLOCK_SHIFT;
+const int BLOCK_MASK = BLOCK_SIZE - 1;
+const int CHUNK_BLOCKS = CHUNK_CELLS / (BLOCK_SIZE * BLOCK_SIZE);
+const uint32_t CHUNKED_MAP_MAX_SIZE = 16384;
+const uint32_t CHUNKED_MAP_HEADER_SIZE = 4096;
+const char CHUNKED_MAP_MAGIC[4] = {'M', 'S', 'C', 'K'};
+const uint32_t CHUNKED_MAP_VERSION = 1;
+const uint8_t CHUNK_PADDING_CELL = 1;
+
+const int DEFAULT_RESIDENT_CHUNKS = 1024;      // 4.5 MB of cells and occupancy
+const int PREFETCH_RADIUS = 1;                 // Chunks around the player
+const double PREFETCH_DISTANCE = 256.0;        // Cells along the view frustum
+const int MAX_PREFETCH_LOADS_PER_FRAME = 16;
+const int MIN_SPARSE_CHUNK_BLOCKS = 56;          // Empty 8x8 blocks (of 64) before rays leap in a chunk
+const int MIN_LEAPING_SPARSE_CHUNK_PERCENT = 50; // Sparse chunks (of all) before a map's rays leap at all
+const uint64_t MIN_BITMAP_TEST_CELLS = 4096 * 4096;  // Map size where rays test the bitmap instead of the bytes
+
+struct ChunkedMapHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t chunkSize;
+    uint32_t chunksX;
+    uint32_t chunksY;
+    float spawnX;
+    float spawnY;
+    uint32_t sparseChunks;  // Chunks with at least MIN_SPARSE_CHUNK_BLOCKS empty blocks
+    uint8_t padding[CHUNKED_MAP_HEADER_SIZE - 40];
+};
+
+static_assert(sizeof(ChunkedMapHeader) == CHUNKED_MAP_HEADER_SIZE, "ChunkedMapHeader layout");
+
+inline size_t chunkCellIndex(int x, int y) {
+    return ((size_t)(x & CHUNK_MASK) << CHUNK_SHIFT) | (size_t)(y & CHUNK_MASK);
+}
+
+// 8x8 block holding (x, y) inside its chunk, and the cell's bit in that block
+inline int chunkBlockIndex(int x, int y) {
+    return (((x & CHUNK_MASK) >> BLOCK_SHIFT) << (CHUNK_SHIFT - BLOCK_SHIFT)) | ((y & CHUNK_MASK) >> BLOCK_SHIFT);
+}
+
+inline uint64_t blockBit(int x, int y) {
+    return (uint64_t)1 << (((x & BLOCK_MASK) << BLOCK_SHIFT) | (y & BLOCK_MASK));
+}
+
+struct ChunkData {
+    uint64_t occupancy[CHUNK_BLOCKS];  // Derived from cells, see buildOccupancy()
+    bool empty;                        // No walls in the whole chunk
+    bool sparse;                       // Mostly empty blocks: rays leap across them
+    uint8_t cells[CHUNK_CELLS];
+
+    bool solid(int x, int y) const {
+        return (occupancy[chunkBlockIndex(x, y)] & blockBit(x, y)) != 0;
+    }
+
+    void buildOccupancy() {
+        memset(occupancy, 0, sizeof(occupancy));
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            for (int y = 0; y < CHUNK_SIZE; y++) {
+                if (cells[chunkCellIndex(x, y)] != 0) {
+                    occupancy[chunkBlockIndex(x, y)] |= blockBit(x, y);
+                }
+            }
+        }
+        int emptyBlocks = 0;
+        for (int i = 0; i < CHUNK_BLOCKS; i++) {
+            if (!occupancy[i]) emptyBlocks++;
+        }
+        empty = emptyBlocks == CHUNK_BLOCKS;
+        sparse = emptyBlocks >= MIN_SPARSE_CHUNK_BLOCKS;
+    }
+};
+
+template<bool BitmapTest, bool Leap> struct ChunkedMapView;
+
+class ChunkedMap {
+private:
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    int chunksX;
+    int chunksY;
+    double spawnPosX;
+    double spawnPosY;
+
+    // chunkTable[cx * chunksY + cy] points into slots, or is nullptr
+    std::vector<const ChunkData*> chunkTable;
+    std::vector<ChunkData> slots;
+    std::vector<int> slotChunk;           // Chunk index held by each slot, -1 if free
+    std::vector<uint64_t> slotLastUsed;
+    int slotCount;
+    int freeSlots;
+    ChunkData solidChunk;
+
+    FILE* file;                           // nullptr when fully resident
+    uint64_t frame;
+    bool bitmapRays;                      // Chosen when the map is loaded, see withRayView()
+    bool leapRays;
+
+    // Statistics
+    uint64_t chunkLoads;
+    uint64_t demandLoads;
+    uint64_t evictions;
+
+    void reset() {
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+        chunkTable.clear();
+        slots.clear();
+        slotChunk.clear();
+        slotLastUsed.clear();
+        mapWidth = mapHeight = 0;
+        chunksX = chunksY = 0;
+        slotCount = freeSlots = 0;
+        frame = 0;
+        bitmapRays = leapRays = false;
+        chunkLoads = demandLoads = evictions = 0;
+    }
+
+    void allocateSlots(int count) {
+        slotCount = count;
+        freeSlots = count;
+        slots.resize(count);
+        slotChunk.assign(count, -1);
+        slotLastUsed.assign(count, 0);
+    }
+
+    int takeSlot() {
+        if (freeSlots > 0) {
+            return slotCount - freeSlots--;
+        }
+
+        // Evict the least recently used chunk
+        int victim = 0;
+        for (int i = 1; i < slotCount; i++) {
+            if (slotLastUsed[i] < slotLastUsed[victim]) victim = i;
+        }
+        chunkTable[slotChunk[victim]] = nullptr;
+        slotChunk[victim] = -1;
+        evictions++;
+        return victim;
+    }
+
+    const ChunkData* load(int index) {
+        int slot = takeSlot();
+        ChunkData& data = slots[slot];
+        long offset = (long)CHUNKED_MAP_HEADER_SIZE + (long)index * CHUNK_CELLS;
+        if (fseek(file, offset, SEEK_SET) != 0 || fread(data.cells, 1, CHUNK_CELLS, file) != (size_t)CHUNK_CELLS) {
+            std::cerr << "Failed to read map chunk " << index << std::endl;
+            memset(data.cells, CHUNK_PADDING_CELL, CHUNK_CELLS);
+        }
+        data.buildOccupancy();
+        slotChunk[slot] = index;
+        slotLastUsed[slot] = frame;
+        chunkTable[index] = &data;
+        chunkLoads++;
+        return &data;
+    }
+
+    // Make (cx, cy) resident and mark it used this frame
+    void touch(int cx, int cy, int& loadBudget) {
+        if (cx < 0 || cy < 0 || cx >= chunksX || cy >= chunksY) return;
+        int index = cx * chunksY + cy;
+        if (chunkTable[index]) {
+            if (file) {
+                size_t slot = chunkTable[index] - slots.data();
+                slotLastUsed[slot] = frame;
+            }
+        } else if (loadBudget > 0) {
+            load(index);
+            loadBudget--;
+        }
+    }
+
+    void setDimensions(uint32_t width, uint32_t height, double spawnX, double spawnY) {
+        mapWidth = width;
+        mapHeight = height;
+        chunksX = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        chunksY = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        spawnPosX = spawnX;
+        spawnPosY = spawnY;
+        chunkTable.assign((size_t)chunksX * chunksY, nullptr);
+    }
+
+    void chooseRayWalk(uint64_t sparseChunks) {
+        bitmapRays = (uint64_t)mapWidth * mapHeight >= MIN_BITMAP_TEST_CELLS;
+        leapRays = sparseChunks * 100 >= (uint64_t)chunksX * chunksY * MIN_LEAPING_SPARSE_CHUNK_PERCENT;
+    }
+
+public:
+    /**
+     * Cell reader for walking the grid cell by cell. It keeps the current
+     * chunk's pointer and goes back to the table only when the walk enters
+     * another chunk. solid() tests the occupancy bitmap with BitmapTest,
+     * the cell byte without; at() reads the texture id. With Leap, emptyShift() is the log2 size of the empty
+     * square (chunk or block) around a cell, 0 if its block has walls;
+     * only sparse chunks report empty blocks, since among scattered walls
+     * a leap saves too few steps to pay for itself. Without Leap it is
+     * always 0 and castRay() compiles to the plain walk.
+     */
+    template<bool BitmapTest, bool Leap>
+    class BasicCursor {
+    private:
+        ChunkedMap& map;
+        int chunkX;
+        int chunkY;
+        const ChunkData* data;
+
+        void enter(int x, int y) {
+            int cx = x >> CHUNK_SHIFT;
+            int cy = y >> CHUNK_SHIFT;
+            if (cx != chunkX || cy != chunkY) {
+                chunkX = cx;
+                chunkY = cy;
+                data = map.chunk(cx, cy);
+            }
+        }
+
+    public:
+        explicit BasicCursor(ChunkedMap& chunkedMap) : map(chunkedMap), chunkX(INT32_MIN), chunkY(INT32_MIN), data(nullptr) {}
+
+        bool solid(int x, int y) {
+            enter(x, y);
+            return BitmapTest ? data->solid(x, y) : data->cells[chunkCellIndex(x, y)] != 0;
+        }
+
+        uint8_t at(int x, int y) {
+            enter(x, y);
+            return data->cells[chunkCellIndex(x, y)];
+        }
+
+        int emptyShift(int x, int y) {
+            if (!Leap) return 0;
+            enter(x, y);
+            if (!data->sparse) return 0;
+            if (data->empty) return CHUNK_SHIFT;
+            return data->occupancy[chunkBlockIndex(x, y)] == 0 ? BLOCK_SHIFT : 0;
+        }
+    };
+
+    typedef BasicCursor<false, false> Cursor;
+
+    ChunkedMap() : mapWidth(0), mapHeight(0), chunksX(0), chunksY(0), spawnPosX(0), spawnPosY(0),
+                   slotCount(0), freeSlots(0), file(nullptr), frame(0), bitmapRays(false), leapRays(false),
+                   chunkLoads(0), demandLoads(0), evictions(0) {
+        memset(solidChunk.cells, CHUNK_PADDING_CELL, sizeof(solidChunk.cells));
+        solidChunk.buildOccupancy();
+    }
+
+    ~ChunkedMap() {
+        reset();
+    }
+
+    int width() const { return (int)mapWidth; }
+    int height() const { return (int)mapHeight; }
+    double spawnX() const { return spawnPosX; }
+    double spawnY() const { return spawnPosY; }
+    bool isStreaming() const { return file != nullptr; }
+    bool bitmapTest() const { return bitmapRays; }
+    bool leaping() const { return leapRays; }
+
+    bool contains(int x, int y) const {
+        return x >= 0 && y >= 0 && x < (int)mapWidth && y < (int)mapHeight;
+    }
+
+    // Copy a loaded map in, with every chunk resident
+    bool fromGameMap(const GameMap& source) {
+        reset();
+        if (!source.isLoaded()) return false;
+
+        setDimensions(source.width(), source.height(), source.spawnX(), source.spawnY());
+        allocateSlots(chunksX * chunksY);
+        uint64_t sparseChunks = 0;
+        for (int cx = 0; cx < chunksX; cx++) {
+            for (int cy = 0; cy < chunksY; cy++) {
+                int index = cx * chunksY + cy;
+                int slot = takeSlot();
+                ChunkData& data = slots[slot];
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+                        int x = cx * CHUNK_SIZE + lx, y = cy * CHUNK_SIZE + ly;
+                        data.cells[chunkCellIndex(x, y)] = source.contains(x, y) ? source.cell(x, y) : CHUNK_PADDING_CELL;
+                    }
+                }
+                data.buildOccupancy();
+                if (data.sparse) sparseChunks++;
+                slotChunk[slot] = index;
+                chunkTable[index] = &data;
+            }
+        }
+        chooseRayWalk(sparseChunks);
+        return true;
+    }
+
+    // Stream chunks from a .msc file, keeping at most residentChunks in memory
+    bool open(const std::string& path, int residentChunks = DEFAULT_RESIDENT_CHUNKS) {
+        reset();
+        file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+
+        ChunkedMapHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            memcmp(header.magic, CHUNKED_MAP_MAGIC, sizeof(CHUNKED_MAP_MAGIC)) != 0 ||
+            header.version != CHUNKED_MAP_VERSION || header.chunkSize != (uint32_t)CHUNK_SIZE) {
+            std::cerr << path << " is not a compatible chunked map" << std::endl;
+            reset();
+            return false;
+        }
+        if (header.width < 3 || header.height < 3 ||
+            header.width > CHUNKED_MAP_MAX_SIZE || header.height > CHUNKED_MAP_MAX_SIZE ||
+            header.chunksX != (header.width + CHUNK_SIZE - 1) / CHUNK_SIZE ||
+            header.chunksY != (header.height + CHUNK_SIZE - 1) / CHUNK_SIZE) {
+            std::cerr << path << " has invalid dimensions" << std::endl;
+            reset();
+            return false;
+        }
+
+        setDimensions(header.width, header.height, header.spawnX, header.spawnY);
+        int chunks = chunksX * chunksY;
+        allocateSlots(residentChunks < chunks ? residentChunks : chunks);
+        chooseRayWalk(header.sparseChunks);
+
+        // The player must start on an open cell inside the map
+        if (!std::isfinite(header.spawnX) || !std::isfinite(header.spawnY) ||
+            header.spawnX < 0 || header.spawnY < 0 ||
+            header.spawnX >= header.width || header.spawnY >= header.height ||
+            cell((int)header.spawnX, (int)header.spawnY) != 0) {
+            std::cerr << path << " has an invalid spawn point" << std::endl;
+            reset();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Write a map as .msc. Chunks are produced one at a time, so this also
+     * works for maps too big for the text format to be practical.
+     */
+    static bool write(const GameMap& source, const std::string& path) {
+        if (!source.isLoaded() || (uint32_t)source.width() > CHUNKED_MAP_MAX_SIZE ||
+            (uint32_t)source.height() > CHUNKED_MAP_MAX_SIZE) {
+            return false;
+        }
+        FILE* out = fopen(path.c_str(), "wb");
+        if (!out) {
+            return false;
+        }
+
+        ChunkedMapHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CHUNKED_MAP_MAGIC, sizeof(CHUNKED_MAP_MAGIC));
+        header.version = CHUNKED_MAP_VERSION;
+        header.width = source.width();
+        header.height = source.height();
+        header.chunkSize = CHUNK_SIZE;
+        header.chunksX = (header.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        header.chunksY = (header.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        header.spawnX = (float)source.spawnX();
+        header.spawnY = (float)source.spawnY();
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+        std::vector<ChunkData> chunk(1);
+        for (uint32_t cx = 0; cx < header.chunksX && ok; cx++) {
+            for (uint32_t cy = 0; cy < header.chunksY && ok; cy++) {
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+                        int x = cx * CHUNK_SIZE + lx, y = cy * CHUNK_SIZE + ly;
+                        chunk[0].cells[chunkCellIndex(x, y)] = source.contains(x, y) ? source.cell(x, y) : CHUNK_PADDING_CELL;
+                    }
+                }
+                chunk[0].buildOccupancy();
+                if (chunk[0].sparse) header.sparseChunks++;
+                ok = fwrite(chunk[0].cells, 1, CHUNK_CELLS, out) == (size_t)CHUNK_CELLS;
+            }
+        }
+
+        // The sparse chunk count is only known once every chunk is written
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+        ok = fclose(out) == 0 && ok;
+        return ok;
+    }
+
+    // Copy every cell into a GameMap (for tools; needs width * height bytes)
+    bool toGameMap(GameMap& target, const std::string& source) {
+        std::vector<uint8_t> cells((size_t)mapWidth * mapHeight);
+        Cursor cursor(*this);
+        for (uint32_t x = 0; x < mapWidth; x++) {
+            for (uint32_t y = 0; y < mapHeight; y++) {
+                cells[(size_t)x * mapHeight + y] = cursor.at(x, y);
+            }
+        }
+        return target.assign(mapWidth, mapHeight, cells, spawnPosX, spawnPosY, source);
+    }
+
+    /**
+     * Chunk (cx, cy), loading it if needed. Chunks outside the map are
+     * solid.
+     */
+    const ChunkData* chunk(int cx, int cy) {
+        if (cx < 0 || cy < 0 || cx >= chunksX || cy >= chunksY) {
+            return &solidChunk;
+        }
+        int index = cx * chunksY + cy;
+        const ChunkData* data = chunkTable[index];
+        if (!data) {
+            demandLoads++;
+            data = load(index);
+        } else if (file) {
+            slotLastUsed[data - slots.data()] = frame;
+        }
+        return data;
+    }
+
+    uint8_t cell(int x, int y) {
+        return chunk(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT)->cells[chunkCellIndex(x, y)];
+    }
+
+    /**
+     * Once per frame: keep the chunks around the player and along the view
+     * frustum (dir +- plane) resident, loading at most
+     * MAX_PREFETCH_LOADS_PER_FRAME of them.
+     */
+    void prefetch(double posX, double posY, double dirX, double dirY, double planeX, double planeY) {
+        frame++;
+        if (!file) return;
+
+        int budget = MAX_PREFETCH_LOADS_PER_FRAME;
+        int playerCX = (int)posX >> CHUNK_SHIFT;
+        int playerCY = (int)posY >> CHUNK_SHIFT;
+        for (int dx = -PREFETCH_RADIUS; dx <= PREFETCH_RADIUS; dx++) {
+            for (int dy = -PREFETCH_RADIUS; dy <= PREFETCH_RADIUS; dy++) {
+                touch(playerCX + dx, playerCY + dy, budget);
+            }
+        }
+
+        // Left edge, centre and right edge of the view, nearest chunks first
+        double edgesX[3] = {dirX - planeX, dirX, dirX + planeX};
+        double edgesY[3] = {dirY - planeY, dirY, dirY + planeY};
+        for (double distance = CHUNK_SIZE / 2; distance <= PREFETCH_DISTANCE; distance += CHUNK_SIZE / 2) {
+            for (int i = 0; i < 3; i++) {
+                double length = std::sqrt(edgesX[i] * edgesX[i] + edgesY[i] * edgesY[i]);
+                double x = posX + edgesX[i] / length * distance;
+                double y = posY + edgesY[i] / length * distance;
+                touch((int)std::floor(x) >> CHUNK_SHIFT, (int)std::floor(y) >> CHUNK_SHIFT, budget);
+            }
+        }
+    }
+
+    size_t residentBytes() const {
+        return slots.size() * sizeof(ChunkData);
+    }
+
+    /**
+     * Call function(view) with this map as the castRay() map type its
+     * rays should use: a ChunkedMapView whose cursor tests the bitmap if
+     * bitmapTest() (the bytes otherwise) and leaps if leaping() (walks
+     * cell by cell otherwise). Decided once per map, so the walk itself
+     * has no per-map test.
+     */
+    template<typename Function>
+    void withRayView(Function& function);
+
+    void printStats() const {
+        if (!file) return;
+        std::cout << "Map streaming: " << chunkLoads << " chunk loads (" << demandLoads << " on demand), "
+                  << evictions << " evictions, " << residentBytes() / 1024 << " KB resident" << std::endl;
+    }
+};
+
+// A ChunkedMap read through BasicCursor<BitmapTest, Leap>, for castRay()
+template<bool BitmapTest, bool Leap>
+struct ChunkedMapView {
+    ChunkedMap& map;
+
+    class Cursor : public ChunkedMap::BasicCursor<BitmapTest, Leap> {
+    public:
+        explicit Cursor(ChunkedMapView& view) : ChunkedMap::BasicCursor<BitmapTest, Leap>(view.map) {}
+    };
+};
+
+template<typename Function>
+inline void ChunkedMap::withRayView(Function& function) {
+    if (bitmapRays && leapRays) {
+        ChunkedMapView<true, true> view = {*this};
+        function(view);
+    } else if (bitmapRays) {
+        ChunkedMapView<true, false> view = {*this};
+        function(view);
+    } else if (leapRays) {
+        ChunkedMapView<false, true> view = {*this};
+        function(view);
+    } else {
+        ChunkedMapView<false, false> view = {*this};
+        function(view);
+    }
+}
+
+#endif // CHUNKED_MAP_H
@@ -0,0 +1,142 @@
+/**
+ * @file compositor.h
+ * @brief Software compositing of HUD sprites into the ARGB8888 frame buffer
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Sprites are stored with premultiplied alpha so blending one pixel is
+ * dst = src + dst * (255 - srcAlpha) / 255. The blend loop handles four
+ * pixels per iteration with SSE2 and skips fully transparent groups.
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct Sprite {
+    int width;
+    int height;
+    std::vector<Uint32> pixels;  // Premultiplied ARGB8888, tightly packed
+
+    Sprite() : width(0), height(0) {}
+};
+
+inline Uint32 premultiplyPixel(Uint32 pixel) {
+    Uint32 a = pixel >> 24;
+    Uint32 r = ((pixel >> 16) & 0xFF) * a / 255;
+    Uint32 g = ((pixel >> 8) & 0xFF) * a / 255;
+    Uint32 b = (pixel & 0xFF) * a / 255;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/**
+ * Build a premultiplied sprite from any surface, enlarged by an integer
+ * scale factor. Color-keyed surfaces (e.g. TTF_RenderText_Solid) become
+ * transparent where the key was. Returns false if conversion fails.
+ */
+inline bool spriteFromSurface(SDL_Surface* surface, int scale, Sprite& sprite) {
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!converted) {
+        return false;
+    }
+
+    sprite.width = converted->w * scale;
+    sprite.height = converted->h * scale;
+    sprite.pixels.resize(sprite.width * sprite.height);
+
+    SDL_LockSurface(converted);
+    for (int y = 0; y < sprite.height; y++) {
+        const Uint32* srcRow = (const Uint32*)((const Uint8*)converted->pixels + (y / scale) * converted->pitch);
+        Uint32* dstRow = &sprite.pixels[y * sprite.width];
+        for (int x = 0; x < sprite.width; x++) {
+            dstRow[x] = premultiplyPixel(srcRow[x / scale]);
+        }
+    }
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+inline Uint32 blendPixel(Uint32 src, Uint32 dst) {
+    Uint32 inverseAlpha = 255 - (src >> 24);
+    Uint32 result = src;
+    for (int shift = 0; shift < 32; shift += 8) {
+        Uint32 product = ((dst >> shift) & 0xFF) * inverseAlpha + 128;
+        result += ((product + (product >> 8)) >> 8) << shift;
+    }
+    return result;
+}
+
+#ifdef __SSE2__
+// Blend the four or two pixels in the low halves of src/dst widened to 16 bits
+inline __m128i blendPixels16(__m128i src16, __m128i dst16) {
+    // Broadcast each pixel's alpha (lane 3) across its four channels
+    __m128i alpha = _mm_shufflelo_epi16(src16, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i inverseAlpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+    // dst * (255 - a) / 255, rounded
+    __m128i product = _mm_add_epi16(_mm_mullo_epi16(dst16, inverseAlpha), _mm_set1_epi16(128));
+    product = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+    return _mm_add_epi16(src16, product);
+}
+#endif
+
+/**
+ * Alpha-blend a premultiplied sprite into an ARGB8888 buffer with its
+ * top-left corner at (x, y), clipped to the buffer.
+ */
+inline void blendSprite(Uint32* dst, int dstWidth, int dstHeight, const Sprite& sprite, int x, int y) {
+    int startX = x < 0 ? -x : 0;
+    int startY = y < 0 ? -y : 0;
+    int endX = sprite.width;
+    int endY = sprite.height;
+    if (x + endX > dstWidth) endX = dstWidth - x;
+    if (y + endY > dstHeight) endY = dstHeight - y;
+    if (startX >= endX || startY >= endY) return;
+
+    for (int row = startY; row < endY; row++) {
+        const Uint32* src = &sprite.pixels[row * sprite.width + startX];
+        Uint32* out = dst + (y + row) * dstWidth + x + startX;
+        int count = endX - startX;
+        int i = 0;
+
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+        for (; i + 4 <= count; i += 4) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i alpha = _mm_and_si128(s, alphaMask);
+
+            // Fully transparent: leave the frame untouched
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) continue;
+
+            // Fully opaque: plain copy
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+                _mm_storeu_si128((__m128i*)(out + i), s);
+                continue;
+            }
+
+            __m128i d = _mm_loadu_si128((const __m128i*)(out + i));
+            __m128i lo = blendPixels16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+            __m128i hi = blendPixels16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+        }
+#endif
+
+        for (; i < count; i++) {
+            Uint32 alpha = src[i] >> 24;
+            if (alpha == 0) continue;
+            out[i] = alpha == 255 ? src[i] : blendPixel(src[i], out[i]);
+        }
+    }
+}
+
+#endif // COMPOSITOR_H
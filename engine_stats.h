@@ -0,0 +1,179 @@
+/**
+ * @file engine_stats.h
+ * @brief Per-frame workload counters, collected per thread without locks
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Code anywhere calls countStat(STAT_..., n). Each thread adds into its
+ * own StatBlock, claimed on first use from a fixed table, with a plain
+ * load and store (relaxed atomics, no locked read-modify-write), so
+ * counting never makes threads wait on each other. The counters only
+ * grow; EngineStats::endFrame() sums every block and keeps the difference
+ * from the previous frame, so a thread's counts survive it exiting.
+ *
+ * The table is constant-initialized and never destroyed, so counting is
+ * safe from operator new, during static initialization and at exit.
+ */
+
+#ifndef ENGINE_STATS_H
+#define ENGINE_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+enum EngineStat {
+    STAT_RAYS,               // Rays traced through the grid
+    STAT_DDA_STEPS,          // Cells and leaps those rays visited
+    STAT_WALL_PIXELS,        // Textured wall pixels written
+    STAT_FILL_PIXELS,        // Other frame buffer writes: background, fog and debug views
+    STAT_TEXELS,             // Wall texture fetches
+    STAT_DRAW_CALLS,         // SDL render calls and frame uploads
+    STAT_TEXTURE_CREATIONS,  // SDL textures created
+    STAT_HEAP_ALLOCATIONS,   // operator new calls by every thread (audio, workers, SDL), not only rendering
+    STAT_COUNT
+};
+
+const char* const ENGINE_STAT_NAMES[STAT_COUNT] = {
+    "rays", "dda_steps", "wall_pixels", "fill_pixels", "texels", "draw_calls", "texture_creations",
+    "process_heap_allocations"
+};
+
+const int STAT_MAX_THREADS = 64;  // Blocks in the table; later threads share the last one
+const int STAT_BLOCK_ALIGN = 64;  // Cache line: each thread's stores stay off its neighbours' lines
+
+struct alignas(STAT_BLOCK_ALIGN) StatBlock {
+    std::atomic<uint64_t> values[STAT_COUNT];
+    std::atomic<bool> inUse;
+};
+
+static_assert(sizeof(StatBlock) % STAT_BLOCK_ALIGN == 0, "StatBlocks share cache lines");
+
+// Zero-initialized at load time; no constructor or destructor runs
+inline StatBlock* statBlocks() {
+    static StatBlock blocks[STAT_MAX_THREADS];
+    return blocks;
+}
+
+inline StatBlock* sharedStatBlock() {
+    return &statBlocks()[STAT_MAX_THREADS - 1];
+}
+
+// The calling thread's block, handed back for reuse when the thread exits
+class StatThread {
+private:
+    StatBlock* block;
+
+public:
+    constexpr StatThread() : block(nullptr) {}
+
+    ~StatThread() {
+        if (block && block != sharedStatBlock()) {
+            block->inUse.store(false, std::memory_order_release);
+        }
+        block = sharedStatBlock();  // Counts made later in this thread's exit
+    }
+
+    StatBlock* get() {
+        if (!block) {
+            StatBlock* blocks = statBlocks();
+            block = sharedStatBlock();
+            for (int i = 0; i < STAT_MAX_THREADS - 1; i++) {
+                bool expected = false;
+                if (blocks[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    block = &blocks[i];
+                    break;
+                }
+            }
+        }
+        return block;
+    }
+};
+
+inline void countStat(EngineStat stat, uint64_t count = 1) {
+    static thread_local StatThread thread;
+    StatBlock* block = thread.get();
+    std::atomic<uint64_t>& value = block->values[stat];
+    if (block == sharedStatBlock()) {
+        value.fetch_add(count, std::memory_order_relaxed);
+    } else {
+        // Only this thread writes the block
+        value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Turns the running totals into per-frame counts. Call endFrame() once per
+ * frame from one thread; frame() then returns the counts made by every
+ * thread since the previous call. Optionally appends each frame to a CSV
+ * file (--stats-csv).
+ */
+class EngineStats {
+private:
+    uint64_t previous[STAT_COUNT];
+    uint64_t current[STAT_COUNT];
+    uint64_t frameNumber;
+    double frameMs;
+    std::chrono::steady_clock::time_point lastFrame;
+    std::ofstream csv;
+
+public:
+    EngineStats() : previous(), current(), frameNumber(0), frameMs(0),
+                    lastFrame(std::chrono::steady_clock::now()) {}
+
+    bool openCsv(const std::string& path) {
+        csv.open(path.c_str());
+        if (!csv) return false;
+        csv << "frame,ms";
+        for (int i = 0; i < STAT_COUNT; i++) {
+            csv << ',' << ENGINE_STAT_NAMES[i];
+        }
+        csv << '\n';
+        return true;
+    }
+
+    void endFrame() {
+        uint64_t totals[STAT_COUNT] = {};
+        StatBlock* blocks = statBlocks();
+        for (int b = 0; b < STAT_MAX_THREADS; b++) {
+            for (int i = 0; i < STAT_COUNT; i++) {
+                totals[i] += blocks[b].values[i].load(std::memory_order_relaxed);
+            }
+        }
+        for (int i = 0; i < STAT_COUNT; i++) {
+            current[i] = totals[i] - previous[i];
+            previous[i] = totals[i];
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        frameMs = std::chrono::duration<double, std::milli>(now - lastFrame).count();
+        lastFrame = now;
+        frameNumber++;
+
+        if (csv.is_open()) {
+            csv << frameNumber << ',' << frameMs;
+            for (int i = 0; i < STAT_COUNT; i++) {
+                csv << ',' << current[i];
+            }
+            csv << '\n';
+        }
+    }
+
+    // Counts of the last finished frame
+    uint64_t frame(EngineStat stat) const {
+        return current[stat];
+    }
+
+    double lastFrameMs() const {
+        return frameMs;
+    }
+
+    uint64_t frames() const {
+        return frameNumber;
+    }
+};
+
+#endif // ENGINE_STATS_H
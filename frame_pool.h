@@ -0,0 +1,116 @@
+/**
+ * @file frame_pool.h
+ * @brief Bounded pool of frame buffers handed from the render loop to a worker
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The render thread takes a free buffer without waiting (tryAcquire), fills
+ * it and submits it; the worker thread waits for submitted buffers and
+ * releases them once processed. The lock is only held for queue updates,
+ * never while a buffer is being copied, converted or written.
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class FramePool {
+private:
+    size_t pixelCount;
+    std::vector<Uint32*> buffers;
+    std::deque<int> freeBuffers;
+    std::deque<int> readyBuffers;
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+    bool closed;
+
+public:
+    FramePool() : pixelCount(0), closed(false) {}
+
+    ~FramePool() {
+        for (size_t i = 0; i < buffers.size(); i++) {
+            delete[] buffers[i];
+        }
+    }
+
+    void allocate(int count, size_t pixels) {
+        pixelCount = pixels;
+        for (int i = 0; i < count; i++) {
+            grow();
+        }
+    }
+
+    /**
+     * Add one more buffer to the free list. Allocates, so keep it off the
+     * per-frame path unless the pool is known to be exhausted.
+     */
+    void grow() {
+        Uint32* buffer = new Uint32[pixelCount];
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(buffer);
+        freeBuffers.push_back(buffers.size() - 1);
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return buffers.size();
+    }
+
+    // Render thread: a free buffer index, or -1 if all are in flight
+    int tryAcquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeBuffers.empty()) {
+            return -1;
+        }
+        int index = freeBuffers.front();
+        freeBuffers.pop_front();
+        return index;
+    }
+
+    // Either thread. grow() may move the pointer table, so read it under the lock; the buffers never move
+    Uint32* buffer(int index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return buffers[index];
+    }
+
+    void submit(int index) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readyBuffers.push_back(index);
+        }
+        readyCondition.notify_one();
+    }
+
+    // Worker thread: next submitted buffer, or -1 once closed and drained
+    int waitReady() {
+        std::unique_lock<std::mutex> lock(mutex);
+        readyCondition.wait(lock, [this] { return closed || !readyBuffers.empty(); });
+        if (readyBuffers.empty()) {
+            return -1;
+        }
+        int index = readyBuffers.front();
+        readyBuffers.pop_front();
+        return index;
+    }
+
+    void release(int index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(index);
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        readyCondition.notify_all();
+    }
+};
+
+#endif // FRAME_POOL_H
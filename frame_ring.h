@@ -0,0 +1,260 @@
+/**
+ * @file frame_ring.h
+ * @brief POSIX shared-memory ring of rendered frames for external capture
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The game (writer) copies every completed frame into the next slot of a
+ * ring in shared memory and never waits for readers. Each slot carries a
+ * sequence number used as a seqlock:
+ *
+ *   sequence == 2n - 1   slot is being overwritten with frame n
+ *   sequence == 2n       slot holds frame n (n >= 1)
+ *
+ * A reader (see frame_ring_cat.cpp) picks frame n from slot n % slotCount,
+ * checks the sequence is 2n, consumes the pixels in place, then re-reads the
+ * sequence; if it changed, the writer lapped the reader and the frame must
+ * be discarded. Frames are native-endian ARGB8888 (BGRA bytes on x86).
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "frame ring needs lock-free 64-bit atomics");
+
+const char FRAME_RING_MAGIC[8] = {'M', 'S', 'F', 'R', 'A', 'M', 'E', 'S'};
+const uint32_t FRAME_RING_VERSION = 1;
+const char* const FRAME_RING_DEFAULT_NAME = "/maze_shooter_frames";
+
+struct FrameRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t slotCount;
+    uint64_t slotStride;                 // Bytes between slots (slot header + pixels)
+    std::atomic<uint64_t> latestFrame;   // Last completely written frame, 0 = none yet
+    uint8_t padding[64 - 40];
+};
+
+struct FrameRingSlot {
+    std::atomic<uint64_t> sequence;
+    uint64_t timestampUs;                // Writer's monotonic clock when published
+    uint8_t padding[64 - 16];
+
+    uint32_t* pixels() {
+        return (uint32_t*)(this + 1);
+    }
+    const uint32_t* pixels() const {
+        return (const uint32_t*)(this + 1);
+    }
+};
+
+static_assert(sizeof(FrameRingHeader) == 64, "FrameRingHeader layout");
+static_assert(sizeof(FrameRingSlot) == 64, "FrameRingSlot layout");
+
+inline uint64_t frameRingSlotStride(uint32_t width, uint32_t height) {
+    uint64_t bytes = sizeof(FrameRingSlot) + (uint64_t)width * height * sizeof(uint32_t);
+    return (bytes + 63) & ~(uint64_t)63;
+}
+
+/**
+ * Publishing side, owned by the game.
+ */
+class FrameRingWriter {
+private:
+    std::string name;
+    uint8_t* base;
+    size_t size;
+    FrameRingHeader* header;
+    uint64_t frameNumber;
+
+public:
+    FrameRingWriter() : base(nullptr), size(0), header(nullptr), frameNumber(0) {}
+
+    ~FrameRingWriter() {
+        close();
+    }
+
+    bool create(const std::string& ringName, uint32_t width, uint32_t height, uint32_t slotCount) {
+        close();
+
+        uint64_t stride = frameRingSlotStride(width, height);
+        size = sizeof(FrameRingHeader) + stride * slotCount;
+
+        int fd = shm_open(ringName.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) {
+            std::cerr << "shm_open " << ringName << " failed" << std::endl;
+            return false;
+        }
+        if (ftruncate(fd, size) != 0) {
+            std::cerr << "Failed to size frame ring " << ringName << std::endl;
+            ::close(fd);
+            shm_unlink(ringName.c_str());
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map frame ring " << ringName << std::endl;
+            shm_unlink(ringName.c_str());
+            return false;
+        }
+
+        name = ringName;
+        base = (uint8_t*)mapped;
+        memset(base, 0, size);
+
+        header = new (base) FrameRingHeader;
+        memcpy(header->magic, FRAME_RING_MAGIC, sizeof(header->magic));
+        header->version = FRAME_RING_VERSION;
+        header->width = width;
+        header->height = height;
+        header->slotCount = slotCount;
+        header->slotStride = stride;
+        header->latestFrame.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < slotCount; i++) {
+            new (slot(i)) FrameRingSlot;
+            slot(i)->sequence.store(0, std::memory_order_relaxed);
+        }
+        frameNumber = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    void close() {
+        if (!base) return;
+        munmap(base, size);
+        shm_unlink(name.c_str());
+        base = nullptr;
+        header = nullptr;
+    }
+
+    bool isOpen() const {
+        return base != nullptr;
+    }
+
+    FrameRingSlot* slot(uint32_t index) {
+        return (FrameRingSlot*)(base + sizeof(FrameRingHeader) + index * header->slotStride);
+    }
+
+    /**
+     * Copy a width * height frame into the next slot. Never blocks; readers
+     * that are still on the overwritten slot detect it via the sequence.
+     */
+    void publish(const uint32_t* pixels, uint64_t timestampUs) {
+        uint64_t n = ++frameNumber;
+        FrameRingSlot* target = slot(n % header->slotCount);
+
+        target->sequence.store(2 * n - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        target->timestampUs = timestampUs;
+        memcpy(target->pixels(), pixels, (size_t)header->width * header->height * sizeof(uint32_t));
+
+        target->sequence.store(2 * n, std::memory_order_release);
+        header->latestFrame.store(n, std::memory_order_release);
+    }
+};
+
+/**
+ * Consuming side, used by capture/encoder processes.
+ */
+class FrameRingReader {
+private:
+    const uint8_t* base;
+    size_t size;
+    const FrameRingHeader* header;
+
+public:
+    FrameRingReader() : base(nullptr), size(0), header(nullptr) {}
+
+    ~FrameRingReader() {
+        close();
+    }
+
+    bool open(const std::string& ringName) {
+        close();
+
+        int fd = shm_open(ringName.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FrameRingHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        base = (const uint8_t*)mapped;
+        size = st.st_size;
+        header = (const FrameRingHeader*)base;
+        if (memcmp(header->magic, FRAME_RING_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != FRAME_RING_VERSION ||
+            sizeof(FrameRingHeader) + header->slotStride * header->slotCount > size) {
+            std::cerr << ringName << " is not a compatible frame ring" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (!base) return;
+        munmap((void*)base, size);
+        base = nullptr;
+        header = nullptr;
+    }
+
+    uint32_t width() const { return header->width; }
+    uint32_t height() const { return header->height; }
+    uint32_t slotCount() const { return header->slotCount; }
+
+    uint64_t latestFrame() const {
+        return header->latestFrame.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Start reading frame n. Returns the slot, or nullptr if the frame is not
+     * (or no longer) in the ring. The pixels may be used in place, but only
+     * count as valid if finishRead() succeeds afterwards.
+     */
+    const FrameRingSlot* beginRead(uint64_t n) const {
+        const FrameRingSlot* target = slot(n % header->slotCount);
+        if (target->sequence.load(std::memory_order_acquire) != 2 * n) {
+            return nullptr;
+        }
+        return target;
+    }
+
+    bool finishRead(const FrameRingSlot* target, uint64_t n) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return target->sequence.load(std::memory_order_relaxed) == 2 * n;
+    }
+
+private:
+    const FrameRingSlot* slot(uint32_t index) const {
+        return (const FrameRingSlot*)(base + sizeof(FrameRingHeader) + index * header->slotStride);
+    }
+};
+
+#endif // FRAME_RING_H
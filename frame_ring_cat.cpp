@@ -0,0 +1,78 @@
+/**
+ * @file frame_ring_cat.cpp
+ * @brief Reads frames from the game's shared-memory ring and writes them to stdout
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Reference consumer for frame_ring.h. Writes raw BGRA frames, e.g.
+ *   ./maze_shooter --frame-ring &
+ *   ./frame_ring_cat | ffmpeg -f rawvideo -pix_fmt bgra -s 800x600 -r 60 -i - capture.mp4
+ * Frames the reader was too slow for are skipped and counted on stderr.
+ * to compile: make frame_ring_cat
+ * usage: ./frame_ring_cat [ring name] [frame count]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include "frame_ring.h"
+
+static void sleepMicroseconds(long us) {
+    struct timespec delay = {0, us * 1000};
+    nanosleep(&delay, nullptr);
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = argc > 1 ? argv[1] : FRAME_RING_DEFAULT_NAME;
+    long long limit = argc > 2 ? atoll(argv[2]) : -1;
+
+    FrameRingReader reader;
+    while (!reader.open(name)) {
+        sleepMicroseconds(100000);  // Wait for the game to start publishing
+    }
+    std::cerr << "Reading " << reader.width() << "x" << reader.height() << " frames from " << name << std::endl;
+
+    std::vector<uint32_t> frame(reader.width() * reader.height());
+    uint64_t next = reader.latestFrame() + 1;
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+
+    while (limit < 0 || (long long)written < limit) {
+        uint64_t latest = reader.latestFrame();
+        if (latest < next) {
+            sleepMicroseconds(1000);
+            continue;
+        }
+
+        // Fell a whole ring behind: skip to the oldest frame still present
+        if (latest - next >= reader.slotCount()) {
+            uint64_t oldest = latest - reader.slotCount() + 1;
+            dropped += oldest - next;
+            next = oldest;
+        }
+
+        const FrameRingSlot* slot = reader.beginRead(next);
+        if (slot) {
+            memcpy(frame.data(), slot->pixels(), frame.size() * sizeof(uint32_t));
+        }
+        if (!slot || !reader.finishRead(slot, next)) {
+            dropped++;
+            next++;
+            continue;
+        }
+
+        if (fwrite(frame.data(), sizeof(uint32_t), frame.size(), stdout) != frame.size()) {
+            break;  // Downstream closed
+        }
+        written++;
+        next++;
+    }
+
+    std::cerr << written << " frames written, " << dropped << " dropped" << std::endl;
+    return 0;
+}
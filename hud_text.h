@@ -0,0 +1,105 @@
+/**
+ * @file hud_text.h
+ * @brief HUD text drawn from glyphs rasterized once at startup
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The FPS counter and the F4 stats change every frame, so rendering them
+ * as whole strings would create a texture (or a cached sprite) per new
+ * string. Instead every printable ASCII character of the HUD font is
+ * rasterized once, as a texture for the renderer and a premultiplied
+ * sprite for software compositing, and a string is drawn glyph by glyph.
+ * Drawing does not allocate or create textures, and its draw calls are
+ * not counted, so the overlay does not inflate the stats it shows.
+ * Kerning is ignored.
+ */
+
+#ifndef HUD_TEXT_H
+#define HUD_TEXT_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "compositor.h"
+#include "engine_stats.h"
+
+const char HUD_FIRST_GLYPH = ' ';
+const char HUD_LAST_GLYPH = '~';
+const int HUD_GLYPH_COUNT = HUD_LAST_GLYPH - HUD_FIRST_GLYPH + 1;
+
+class HudText {
+private:
+    SDL_Texture* textures[HUD_GLYPH_COUNT];  // nullptr without a renderer
+    Sprite sprites[HUD_GLYPH_COUNT];
+    int advances[HUD_GLYPH_COUNT];
+
+public:
+    HudText() {
+        for (int i = 0; i < HUD_GLYPH_COUNT; i++) {
+            textures[i] = nullptr;
+            advances[i] = 0;
+        }
+    }
+
+    ~HudText() {
+        free();
+    }
+
+    // Rasterize the glyphs in color; renderer may be nullptr (compositing only)
+    void load(TTF_Font* font, SDL_Renderer* renderer, SDL_Color color) {
+        free();
+        if (!font) return;
+
+        for (int i = 0; i < HUD_GLYPH_COUNT; i++) {
+            char text[2] = {(char)(HUD_FIRST_GLYPH + i), '\0'};
+            int height;
+            TTF_SizeText(font, text, &advances[i], &height);
+            SDL_Surface* surface = TTF_RenderText_Solid(font, text, color);
+            if (!surface) continue;  // Blank glyphs may have no surface; the advance still applies
+
+            spriteFromSurface(surface, 1, sprites[i]);
+            if (renderer) {
+                textures[i] = SDL_CreateTextureFromSurface(renderer, surface);
+                countStat(STAT_TEXTURE_CREATIONS);
+            }
+            SDL_FreeSurface(surface);
+        }
+    }
+
+    void free() {
+        for (int i = 0; i < HUD_GLYPH_COUNT; i++) {
+            if (textures[i]) {
+                SDL_DestroyTexture(textures[i]);
+                textures[i] = nullptr;
+            }
+        }
+    }
+
+    // Renderer path; characters outside printable ASCII are skipped
+    void render(SDL_Renderer* renderer, const char* text, int x, int y) const {
+        for (; *text; text++) {
+            if (*text < HUD_FIRST_GLYPH || *text > HUD_LAST_GLYPH) continue;
+            int i = *text - HUD_FIRST_GLYPH;
+            if (textures[i]) {
+                SDL_Rect rect = {x, y, sprites[i].width, sprites[i].height};
+                SDL_RenderCopy(renderer, textures[i], nullptr, &rect);
+            }
+            x += advances[i];
+        }
+    }
+
+    // Compositing path: blend into an ARGB8888 buffer
+    void blend(Uint32* buffer, int bufferWidth, int bufferHeight, const char* text, int x, int y) const {
+        for (; *text; text++) {
+            if (*text < HUD_FIRST_GLYPH || *text > HUD_LAST_GLYPH) continue;
+            int i = *text - HUD_FIRST_GLYPH;
+            if (!sprites[i].pixels.empty()) {
+                blendSprite(buffer, bufferWidth, bufferHeight, sprites[i], x, y);
+            }
+            x += advances[i];
+        }
+    }
+};
+
+#endif // HUD_TEXT_H
@@ -7,7 +7,7 @@
  * 
  * This is the main entry point for the Maze Shooter game. It initializes the
  * SDL library, creates a game window, and starts the main game loop.
- * to compile: g++ -o maze_shooter main.cpp `pkg-config --cflags --libs sdl2 SDL2_image SDL2_mixer SDL2_ttf` -lm 
+ * to compile: g++ -o maze_shooter main.cpp `pkg-config --cflags --libs sdl2 SDL2_image SDL2_mixer SDL2_ttf` -lm -lrt -pthread
  */
 
 #include <SDL2/SDL.h>
@@ -19,13 +19,62 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <atomic>
 
+#include "asset_pack.h"
+#include "audio_latency.h"
+#include "compositor.h"
+#include "chunked_map.h"
+#include "engine_stats.h"
+#include "hud_text.h"
+#include "map.h"
+#include "maze_generator.h"
+#include "raycast.h"
+#include "music_cache.h"
+#include "present.h"
+#include "pvs.h"
+#include "sample_bank.h"
+#include "screenshot.h"
+#include "spatial_audio.h"
+#include "texture_utils.h"
+#include "video_recorder.h"
+#include "voice_mixer.h"
+
+#ifndef _WIN32
+#include "frame_ring.h"
+#endif
+
+#ifdef MAZE_XSHM
+#include <SDL2/SDL_syswm.h>
+#include "xshm_present.h"
+#endif
+
+// Count heap allocations for the frame stats (new[] and the nothrow forms go through these). Process-wide: every thread counts, not just the render thread
+void* operator new(size_t size) {
+    countStat(STAT_HEAP_ALLOCATIONS);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
 
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
-const int MAP_WIDTH = 24;
-const int MAP_HEIGHT = 24;
 const double FOV = M_PI / 3;  // 60 degrees field of view
 const double MOVE_SPEED = 0.05;
 const double ROT_SPEED = 0.03;
@@ -33,15 +82,45 @@ const double JUMP_SPEED = 0.15;
 const double GRAVITY = 0.01;
 const double GROUND_HEIGHT = 0.0;
 
+// Background and distance fog
+const Uint32 SKY_COLOR = 0xFF87CEEB;
+const Uint32 FLOOR_COLOR = 0xFF555555;
+const double DEFAULT_VIEW_DISTANCE = 64.0;  // Cells; rays stop here (--view-distance)
+const double FOG_START = 0.6;               // Fraction of the view distance where fog begins
+const int FOG_LUT_SIZE = 256;
+const int MAX_WALL_SPAN = 32;               // Columns between traced rays (--wall-spans)
+const int STEP_VIEW_MAX_STEPS = 48;         // DDA steps shown fully red in the step view (F3)
+const int STEP_VIEW_COLORS = 256;           // Floor heat ramp entries in the step view
+const int DEFAULT_GENERATED_MAP_SIZE = 63;  // Cells per side for --generate (--map-size)
+
 // Texture dimensions
-const int TEXTURE_WIDTH = 64;
+const int TEXTURE_WIDTH = 64;   // Base texture size
 const int TEXTURE_HEIGHT = 64;
+const int MIN_TEXTURE_SIZE = 32;   // Wall textures are 32, 64, 128 or 256 square
+const int MAX_TEXTURE_SIZE = 256;
 const int NUM_TEXTURES = 8;
 
 // Gun animation constants
 const int GUN_FRAMES = 4;  // idle, fire1, fire2, fire3
 const int ANIMATION_SPEED = 100; // milliseconds per frame
 
+// Mixer channel reserved for decoded music (--music-cache)
+const int MUSIC_CHANNEL = 0;
+
+// Audio device buffer, in sample frames (--audio-buffer)
+const int DEFAULT_AUDIO_RATE = 44100;
+const int DEFAULT_AUDIO_BUFFER = 2048;
+const int MAX_AUDIO_BUFFER = 8192;
+const Uint32 UNDERRUN_CHECK_INTERVAL = 1000;  // ms
+const Uint32 UNDERRUN_LIMIT = 2;              // Per interval before the buffer grows
+
+// Test sound emitters (--sound-sources)
+const Uint32 TEST_EMITTER_MIN_INTERVAL = 500;   // ms between shots
+const Uint32 TEST_EMITTER_MAX_INTERVAL = 1500;
+
+// Shared-memory frame ring (--frame-ring)
+const int FRAME_RING_SLOTS = 8;
+
 // Game states
 enum GameState {
     STATE_MENU,
@@ -56,32 +135,64 @@ enum MenuItem {
     MENU_ITEM_COUNT
 };
 
-// Simple map layout (wall >=1, empty space = 0)
-int worldMap[MAP_WIDTH][MAP_HEIGHT] = {
-    {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,2,2,2,2,2,0,0,0,0,3,0,3,0,3,0,0,0,1},
-    {1,0,0,0,0,0,2,0,0,0,2,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,2,0,0,0,2,0,0,0,0,3,0,0,0,3,0,0,0,1},
-    {1,0,0,0,0,0,2,0,0,0,2,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,2,2,0,2,2,0,0,0,0,3,0,3,0,3,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,4,4,4,4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,4,0,4,0,0,0,0,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,4,0,0,0,0,5,0,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,4,0,4,0,0,0,0,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,4,4,4,4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1},
-    {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1}
+// Presentation backends
+enum PresentBackend {
+    PRESENT_AUTO,      // Accelerated renderer, falling back to the window surface
+    PRESENT_RENDERER,  // SDL_Renderer only
+    PRESENT_SURFACE,   // Blit screenBuffer to the window surface, no SDL_Renderer
+    PRESENT_XSHM       // Render into an X11 shared-memory image (MAZE_XSHM builds)
+};
+
+const char* const DEFAULT_MAP_FILE = "maps/level1.txt";
+
+// Built-in copy of maps/level1.txt, used when no map file can be loaded
+const char* const DEFAULT_MAP =
+    "111111111111111111111111\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000222220000303030001\n"
+    "100000200020000000000001\n"
+    "100000200020000300030001\n"
+    "100000200020000000000001\n"
+    "100000220220000303030001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000000000000001\n"
+    "144444444000000000000001\n"
+    "140400004000000000000001\n"
+    "140000504000000000000001\n"
+    "140400004000000000000001\n"
+    "144444444000000000000001\n"
+    "100000000000000000000001\n"
+    "100000000000P00000000001\n"
+    "111111111111111111111111\n";
+
+// Wall test for sound occlusion; anything off the map counts as wall
+struct MapWalls {
+    ChunkedMap& map;
+    const VisibilitySet& pvs;
+    
+    MapWalls(ChunkedMap& world, const VisibilitySet& visibility) : map(world), pvs(visibility) {}
+    
+    bool operator()(int x, int y) const {
+        return map.cell(x, y) > 0;
+    }
+    
+    // The PVS is sampled, so only its bounding box is trusted for culling; inside it the occlusion ray decides
+    bool potentiallyVisible(int fromX, int fromY, int toX, int toY) const {
+        return !pvs.isBuilt() || pvs.withinBounds(fromX, fromY, toX, toY);
+    }
+};
+
+// A spot on the map that keeps firing, for exercising positional audio
+struct TestEmitter {
+    double x, y;
+    Uint32 nextShot;
 };
 
 class MazeShooter {
@@ -89,7 +200,34 @@ private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Texture* screenTexture;
+    SDL_Surface* windowSurface;
+    PresentBackend presentBackend;
     Uint32* screenBuffer;
+    Uint32* ownedScreenBuffer;  // screenBuffer may instead point at shared image memory
+#ifdef MAZE_XSHM
+    XShmPresenter xshmPresenter;
+#endif
+    
+    // Present timing, for comparing backends
+    Uint64 presentTime;
+    Uint32 presentCount;
+    
+    // Benchmark mode: play a fixed number of frames without pacing
+    int benchFrames;
+    
+    // Raw video dump (--record)
+    std::string recordPath;
+    VideoRecorder recorder;
+    
+    // F12 screenshots, grabbed when the current frame completes
+    ScreenshotWriter screenshots;
+    bool screenshotRequested;
+    
+#ifndef _WIN32
+    // Completed frames published to shared memory for capture tools
+    std::string frameRingName;
+    FrameRingWriter frameRing;
+#endif
     bool running;
     
     // Game state
@@ -100,18 +238,43 @@ private:
     TTF_Font* titleFont;
     TTF_Font* menuFont;
     TTF_Font* copyrightFont;
+    HudText hudText;  // copyrightFont's glyphs, for the per-frame HUD text
     
     // Menu background
     SDL_Texture* menuBackground;
+    std::vector<Uint32> menuBackgroundPixels;  // Screen-sized copy for compositing
     
     // Audio
-    Mix_Music* menuMusic;
-    Mix_Music* gameMusic;
-    Mix_Chunk* shootSound;
+    CachedMusic menuMusic;
+    CachedMusic gameMusic;
+    MusicCacheMode musicCacheMode;
+    CachedMusic* currentMusic;     // Last track played, moved to its PCM once decoded
+    
+    // Audio device configuration and monitoring
+    int audioRate;
+    int audioBuffer;
+    AudioMonitor audioMonitor;
+    Uint32 lastUnderrunCheck;
+    bool audioBufferCapped;  // The device refused a larger buffer once
+    bool latencyTest;
+    LatencyProbe latencyProbe;
+    
+    // Sound effects mixer with a large voice pool (SDL_mixer channels as fallback)
+    VoiceMixer voiceMixer;
+    
+    // Sounds positioned on the map
+    SpatialAudio spatialAudio;
+    int testEmitterCount;
+    std::vector<TestEmitter> testEmitters;
+    SampleBank sampleBank;     // Effects in the device format
+    Mix_Chunk* shootSound;     // Points into sampleBank
     bool musicEnabled;
     
     // Gun system
     SDL_Texture* gunSprites[GUN_FRAMES];
+    int gunWidths[GUN_FRAMES];
+    int gunHeights[GUN_FRAMES];
+    Sprite gunFrames[GUN_FRAMES];  // Premultiplied, pre-scaled copies for compositing
     int currentGunFrame;
     bool isShooting;
     Uint32 animationTimer;
@@ -135,20 +298,102 @@ private:
     // Input states
     bool keys[SDL_NUM_SCANCODES];
     
-    // Optimized texture data
-    Uint32 texture[NUM_TEXTURES][TEXTURE_WIDTH * TEXTURE_HEIGHT];
+    // Software compositing: draw the HUD and menu into screenBuffer instead of
+    // issuing separate render copies (automatic on software renderers and the
+    // window surface backend)
+    bool softwareCompositing;
+    std::map<std::string, Sprite> textSprites;
+    
+    // Optimized texture data. Each slot points either into the mapped asset
+    // pack (zero-copy) or into textureStorage for textures decoded at runtime.
+    // Slots are square and power-of-two sized between MIN_TEXTURE_SIZE and
+    // MAX_TEXTURE_SIZE, so a map can mix resolutions. Slot 0 is solid magenta
+    // and stands in for invalid texture ids.
+    const Uint32* texture[NUM_TEXTURES];
+    int textureSize[NUM_TEXTURES];
+    std::vector<Uint32> textureStorage[NUM_TEXTURES];
+    
+    // Pre-baked assets (assets.pak), mapped for the lifetime of the game
+    AssetPack assetPack;
+    
+    // Level layout (--map), falling back to DEFAULT_MAP
+    std::string mapPath;
+    ChunkedMap world;
+    
+    // Procedural level (--generate) instead of a map file
+    bool generateMap;
+    MazeAlgorithm mazeAlgorithm;
+    int generatedMapSize;
+    uint64_t mazeSeed;
+    
+    // Bounding box of the potentially visible cells per empty cell (not for streamed maps), cached in <map>.pvs
+    // Built on pvsThread into pendingPvs when there is no cache, and swapped in once ready
+    bool pvsEnabled;
+    VisibilitySet pvs;
+    VisibilitySet pendingPvs;
+    std::thread pvsThread;
+    std::atomic<bool> pvsReady;
+    std::atomic<bool> pvsCancel;
+    
+    // Far plane: fog weight (0..256) by distance, FOG_LUT_SIZE steps up to viewDistance
+    double viewDistance;
+    Uint16 fogLut[FOG_LUT_SIZE];
+    
+    // Wall spans (--wall-spans): trace some columns, fill the rest from shared faces
+    bool wallSpans;
+    RayHit columnHits[SCREEN_WIDTH];
+    
+    // Step view (F3): walls tinted by DDA steps, floor by how often rays visited each cell
+    bool stepView;
+    std::vector<Uint16> cellVisits;  // visitSize x visitSize cells around the player
+    int visitSize;
+    int visitOriginX, visitOriginY;
+    
+    struct CellVisitCounter {
+        MazeShooter* game;
+        void operator()(int x, int y) const {
+            unsigned localX = x - game->visitOriginX, localY = y - game->visitOriginY;
+            if (localX < (unsigned)game->visitSize && localY < (unsigned)game->visitSize) {
+                Uint16& visits = game->cellVisits[localX * game->visitSize + localY];
+                if (visits < 0xFFFF) visits++;
+            }
+        }
+    };
+    
+    // Workload counters per frame (F4 overlay, --stats-csv)
+    EngineStats engineStats;
+    bool statsOverlay;
+    std::string statsCsvPath;
+    
+    // Rays traced and wall columns drawn, summed until the next FPS update
+    Uint32 raysTraced;
+    Uint32 columnsDrawn;
+    double raysPerFrame;
+    double columnsPerFrame;
     
 public:
-    MazeShooter() : window(nullptr), renderer(nullptr), screenTexture(nullptr), screenBuffer(nullptr), 
+    MazeShooter() : window(nullptr), renderer(nullptr), screenTexture(nullptr), windowSurface(nullptr),
+                    presentBackend(PRESENT_AUTO), screenBuffer(nullptr), ownedScreenBuffer(nullptr),
+                    presentTime(0), presentCount(0), benchFrames(0), screenshotRequested(false),
                     titleFont(nullptr), menuFont(nullptr), copyrightFont(nullptr), menuBackground(nullptr),
-                    menuMusic(nullptr), gameMusic(nullptr), shootSound(nullptr), musicEnabled(true), 
+                    musicCacheMode(MUSIC_CACHE_OFF), currentMusic(nullptr),
+                    audioRate(DEFAULT_AUDIO_RATE), audioBuffer(DEFAULT_AUDIO_BUFFER), lastUnderrunCheck(0),
+                    audioBufferCapped(false), latencyTest(false), testEmitterCount(0), shootSound(nullptr), musicEnabled(true), 
                     currentGunFrame(0), isShooting(false), animationTimer(0), 
-                    currentState(STATE_MENU), selectedMenuItem(MENU_NEW_GAME), running(true) {
-        // Initialize player position and direction
-        posX = 22.0; posY = 12.0;  // Starting position
+                    currentState(STATE_MENU), selectedMenuItem(MENU_NEW_GAME), running(true), softwareCompositing(false),
+                    mapPath(DEFAULT_MAP_FILE), generateMap(false), mazeAlgorithm(MAZE_BACKTRACKER),
+                    generatedMapSize(DEFAULT_GENERATED_MAP_SIZE), mazeSeed(1), pvsEnabled(true), pvsReady(false), pvsCancel(false),
+                    viewDistance(DEFAULT_VIEW_DISTANCE), wallSpans(false),
+                    stepView(false), visitSize(0), visitOriginX(0), visitOriginY(0), statsOverlay(false),
+                    raysTraced(0), columnsDrawn(0), raysPerFrame(0), columnsPerFrame(0) {
+        // Initialize player position and direction (moved to the map's spawn point in startNewGame)
+        posX = 0.0; posY = 0.0;
         dirX = -1.0; dirY = 0.0;   // Initial direction (facing left)
         planeX = 0.0; planeY = 0.66; // Camera plane (perpendicular to direction)
         
+        spatialAudio.init(&voiceMixer);
+        buildFogLut();
+        
         // Initialize jumping mechanics
         cameraHeight = GROUND_HEIGHT;
         verticalVelocity = 0.0;
@@ -163,6 +408,8 @@ public:
         // Initialize gun sprites to nullptr
         for (int i = 0; i < GUN_FRAMES; i++) {
             gunSprites[i] = nullptr;
+            gunWidths[i] = 0;
+            gunHeights[i] = 0;
         }
         
         // Initialize input states
@@ -170,51 +417,50 @@ public:
             keys[i] = false;
         }
         
-        // Load textures from PNG files only
+        for (int i = 0; i < NUM_TEXTURES; i++) {
+            textureStorage[i].assign(TEXTURE_WIDTH * TEXTURE_HEIGHT, 0xFFFF00FF);
+            texture[i] = textureStorage[i].data();
+            textureSize[i] = TEXTURE_WIDTH;
+        }
+        
+        // Map the pre-baked asset pack if one has been built
+        if (assetPack.open(ASSET_PACK_FILE)) {
+            std::cout << "Using pre-baked assets from " << ASSET_PACK_FILE << std::endl;
+        }
+        
+        // Load textures from the asset pack or PNG files
         loadTextures();
     }
     
-    bool loadTextureFromPNG(int textureNum, const std::string& filename) {
-        SDL_Surface* surface = IMG_Load(filename.c_str());
-        if (!surface) {
-            std::cerr << "Failed to load texture " << filename << ": " << IMG_GetError() << std::endl;
+    bool loadTextureFromPack(int textureNum, const std::string& filename) {
+        const AssetPackEntry* entry = assetPack.find(filename, ASSET_PIXELS);
+        if (!entry || entry->width != entry->height ||
+            (int)entry->width != chooseTextureSize(entry->width, entry->height, MIN_TEXTURE_SIZE, MAX_TEXTURE_SIZE)) {
             return false;
         }
         
-        // Convert surface to our desired format if needed
-        SDL_Surface* convertedSurface = nullptr;
-        if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
-            convertedSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
-            SDL_FreeSurface(surface);
-            surface = convertedSurface;
-        }
-        
+        // Already in engine layout; use the mapped pixels directly
+        texture[textureNum] = (const Uint32*)assetPack.entryData(entry);
+        textureSize[textureNum] = entry->width;
+        return true;
+    }
+    
+    bool loadTextureFromPNG(int textureNum, const std::string& filename) {
+        SDL_Surface* surface = loadSurfaceARGB8888(filename);
         if (!surface) {
-            std::cerr << "Failed to convert surface format for " << filename << std::endl;
             return false;
         }
         
         // Lock surface for pixel access
         SDL_LockSurface(surface);
         
-        Uint32* pixels = (Uint32*)surface->pixels;
-        int width = surface->w;
-        int height = surface->h;
-        
-        // Copy and scale texture to our fixed size
-        for (int y = 0; y < TEXTURE_HEIGHT; y++) {
-            for (int x = 0; x < TEXTURE_WIDTH; x++) {
-                // Scale coordinates to source image
-                int srcX = (x * width) / TEXTURE_WIDTH;
-                int srcY = (y * height) / TEXTURE_HEIGHT;
-                
-                // Ensure we don't go out of bounds
-                if (srcX >= width) srcX = width - 1;
-                if (srcY >= height) srcY = height - 1;
-                
-                texture[textureNum][TEXTURE_WIDTH * y + x] = pixels[srcY * width + srcX];
-            }
-        }
+        // Filter the texture down (or up) to a power-of-two size the renderer can wrap
+        int size = chooseTextureSize(surface->w, surface->h, MIN_TEXTURE_SIZE, MAX_TEXTURE_SIZE);
+        textureStorage[textureNum].resize(size * size);
+        resampleTexture((const Uint32*)surface->pixels, surface->w, surface->h, surface->pitch / sizeof(Uint32),
+                        textureStorage[textureNum].data(), size, size);
+        texture[textureNum] = textureStorage[textureNum].data();
+        textureSize[textureNum] = size;
         
         SDL_UnlockSurface(surface);
         SDL_FreeSurface(surface);
@@ -223,37 +469,142 @@ public:
         return true;
     }
     
+    /**
+     * Load an image as an ARGB8888 surface, preferring the pre-decoded copy in
+     * the asset pack. Pack surfaces wrap the mapped pixels without copying.
+     */
+    SDL_Surface* loadImage(const std::string& filename) {
+        const AssetPackEntry* entry = assetPack.find(filename, ASSET_PIXELS);
+        if (entry) {
+            return SDL_CreateRGBSurfaceWithFormatFrom((void*)assetPack.entryData(entry), entry->width, entry->height,
+                                                      32, entry->width * sizeof(Uint32), SDL_PIXELFORMAT_ARGB8888);
+        }
+        return IMG_Load(filename.c_str());
+    }
+    
+    /**
+     * Open a read-only stream over a file, preferring the copy in the asset pack.
+     */
+    SDL_RWops* openAsset(const std::string& filename) {
+        const AssetPackEntry* entry = assetPack.find(filename, ASSET_BLOB);
+        if (entry) {
+            return SDL_RWFromConstMem(assetPack.entryData(entry), (int)entry->size);
+        }
+        return SDL_RWFromFile(filename.c_str(), "rb");
+    }
+    
     void createErrorTexture(int textureNum) {
+        textureStorage[textureNum].resize(TEXTURE_WIDTH * TEXTURE_HEIGHT);
+        
         // Create a simple error texture (magenta and black checkerboard)
         for (int y = 0; y < TEXTURE_HEIGHT; y++) {
             for (int x = 0; x < TEXTURE_WIDTH; x++) {
                 bool checker = ((x / 8) + (y / 8)) % 2;
-                texture[textureNum][TEXTURE_WIDTH * y + x] = checker ? 0xFFFF00FF : 0xFF000000; // Magenta/Black
+                textureStorage[textureNum][TEXTURE_WIDTH * y + x] = checker ? 0xFFFF00FF : 0xFF000000; // Magenta/Black
             }
         }
+        texture[textureNum] = textureStorage[textureNum].data();
+        textureSize[textureNum] = TEXTURE_WIDTH;
         std::cout << "Created error texture for slot " << textureNum << std::endl;
     }
     
+    void loadMap() {
+        stopVisibilityBuild();  // It reads the world being replaced
+        GameMap map;
+        if (generateMap) {
+            auto start = std::chrono::steady_clock::now();
+            MazeGenerator generator(generatedMapSize, generatedMapSize, mazeSeed);
+            if (generator.generate(mazeAlgorithm, map) && world.fromGameMap(map)) {
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Generated " << mazeAlgorithmName(mazeAlgorithm) << " maze (" << world.width() << "x"
+                          << world.height() << ", seed " << mazeSeed << ") in " << ms << " ms" << std::endl;
+                // Same algorithm, size and seed give the same maze, so its PVS can be cached too
+                loadVisibility("maps/" + std::string(mazeAlgorithmName(mazeAlgorithm)) + "-" +
+                               std::to_string(generatedMapSize) + "-" + std::to_string(mazeSeed) + ".pvs");
+                return;
+            }
+            std::cout << "Could not generate a " << generatedMapSize << "x" << generatedMapSize
+                      << " maze - using the built-in map" << std::endl;
+            map.parseText(DEFAULT_MAP, "built-in map");
+            world.fromGameMap(map);
+            loadVisibility("");
+            return;
+        }
+        
+        // Chunked maps stream from disk; the others are small enough to copy in whole
+        bool loaded = hasExtension(mapPath, ".msc") ? world.open(mapPath) : (map.load(mapPath) && world.fromGameMap(map));
+        if (loaded) {
+            std::cout << "Loaded map " << mapPath << " (" << world.width() << "x" << world.height()
+                      << (world.isStreaming() ? ", streamed" : "") << ")" << std::endl;
+            loadVisibility(mapPath + ".pvs");
+            return;
+        }
+        std::cout << "Could not load map " << mapPath << " - using the built-in map" << std::endl;
+        map.parseText(DEFAULT_MAP, "built-in map");
+        world.fromGameMap(map);
+        loadVisibility("");
+    }
+    
+    /**
+     * Use the cached PVS if it matches the map. Otherwise build it in the
+     * background (and cache it when cachePath is set); the game runs
+     * without culling until pollVisibilityBuild() swaps it in.
+     */
+    void loadVisibility(const std::string& cachePath) {
+        stopVisibilityBuild();
+        pvs.clear();
+        if (!pvsEnabled || world.isStreaming()) return;
+        
+        if (!cachePath.empty() && pvs.load(cachePath, world, world.width(), world.height(), viewDistance)) {
+            pvs.printStats();
+            return;
+        }
+        if (!VisibilitySet::fits(world.width(), world.height())) {
+            std::cout << "Map too big for a PVS - visibility culling disabled" << std::endl;
+            return;
+        }
+        std::cout << "Building the PVS in the background (maptool pvs builds it offline)" << std::endl;
+        pvsThread = std::thread([this, cachePath]() {
+            if (!pendingPvs.build(world, world.width(), world.height(), viewDistance, &pvsCancel)) return;
+            pendingPvs.printStats();
+            if (!cachePath.empty() && !pendingPvs.save(cachePath)) {
+                std::cout << "Could not write PVS cache " << cachePath << std::endl;
+            }
+            pvsReady = true;
+        });
+    }
+    
+    // Once per tick: take over a finished background build
+    void pollVisibilityBuild() {
+        if (!pvsReady) return;
+        pvsThread.join();
+        pvs = std::move(pendingPvs);
+        pendingPvs.clear();
+        pvsReady = false;
+    }
+    
+    void stopVisibilityBuild() {
+        if (pvsThread.joinable()) {
+            pvsCancel = true;
+            pvsThread.join();
+            pvsCancel = false;
+        }
+        pendingPvs.clear();
+        pvsReady = false;
+    }
+    
     void loadTextures() {
-        std::cout << "Loading textures from PNG files only..." << std::endl;
-        
-        // List of required texture filenames
-        std::vector<std::string> textureFiles = {
-            "", // Index 0 unused
-            "textures/wall1.png",    // Brick wall
-            "textures/wall2.png",    // Stone wall
-            "textures/wall3.png",    // Blue wall
-            "textures/wall4.png",    // White wall
-            "textures/wall5.png",    // Wood wall
-            "textures/wall6.png",    // Green wall
-            "textures/wall7.png"     // Purple wall
-        };
-        
-        // Try to load each texture from PNG file only
+        std::cout << "Loading textures..." << std::endl;
+        
+        // Try to load each texture from the asset pack, then from its PNG file
         bool allTexturesLoaded = true;
         for (int i = 1; i < NUM_TEXTURES; i++) {
-            if (i < textureFiles.size() && !textureFiles[i].empty()) {
-                if (!loadTextureFromPNG(i, textureFiles[i])) {
+            if (i - 1 < WALL_TEXTURE_COUNT) {
+                const std::string filename = WALL_TEXTURE_FILES[i - 1];
+                if (loadTextureFromPack(i, filename)) {
+                    continue;
+                }
+                if (!loadTextureFromPNG(i, filename)) {
                     createErrorTexture(i);
                     allTexturesLoaded = false;
                 }
@@ -272,11 +623,14 @@ public:
     
     void loadFonts() {
         std::cout << "Loading fonts..." << std::endl;
-        const std::string fontPath = "fonts/font.ttf"; // Use a default path for simplicity
+        const std::string fontPath = FONT_FILE;
 
-        titleFont = TTF_OpenFont(fontPath.c_str(), 48);
-        menuFont = TTF_OpenFont(fontPath.c_str(), 24);
-        copyrightFont = TTF_OpenFont(fontPath.c_str(), 16);
+        titleFont = TTF_OpenFontRW(openAsset(fontPath), 1, 48);
+        menuFont = TTF_OpenFontRW(openAsset(fontPath), 1, 24);
+        copyrightFont = TTF_OpenFontRW(openAsset(fontPath), 1, 16);
+        
+        SDL_Color hudColor = {255, 255, 255, 255};
+        hudText.load(copyrightFont, renderer, hudColor);
         
         if (titleFont && menuFont && copyrightFont) {
             std::cout << "Fonts loaded successfully from: " << fontPath << std::endl;
@@ -287,13 +641,30 @@ public:
     
     void loadMenuBackground() {
         std::cout << "Loading menu background..." << std::endl;
-        const std::string path = "menu.jpg"; // Default fallback
-        SDL_Surface* surface = IMG_Load(path.c_str());
+        const std::string path = MENU_BACKGROUND_FILE;
+        SDL_Surface* surface = loadImage(path);
         if (surface) {
-            menuBackground = SDL_CreateTextureFromSurface(renderer, surface);
+            if (renderer) {
+                menuBackground = SDL_CreateTextureFromSurface(renderer, surface);
+                countStat(STAT_TEXTURE_CREATIONS);
+            }
+            
+            if (softwareCompositing) {
+                // Pre-scale once so drawing the menu is a plain copy
+                SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+                if (converted) {
+                    menuBackgroundPixels.resize(SCREEN_WIDTH * SCREEN_HEIGHT);
+                    SDL_LockSurface(converted);
+                    resampleTexture((const Uint32*)converted->pixels, converted->w, converted->h,
+                                    converted->pitch / sizeof(Uint32), menuBackgroundPixels.data(),
+                                    SCREEN_WIDTH, SCREEN_HEIGHT);
+                    SDL_UnlockSurface(converted);
+                    SDL_FreeSurface(converted);
+                }
+            }
             SDL_FreeSurface(surface);
             
-            if (menuBackground) {
+            if (menuBackground || !menuBackgroundPixels.empty()) {
                 std::cout << "Menu background loaded from: " << path << std::endl;
                 return;
             }
@@ -309,18 +680,12 @@ public:
         std::cout << "Loading music..." << std::endl;
         
         // Load menu music
-        menuMusic = Mix_LoadMUS("music/menu.mp3");
-        if (!menuMusic) {
-            std::cout << "Could not load music/menu.mp3: " << Mix_GetError() << std::endl;
-        } else {
+        if (menuMusic.load("music/menu.mp3", musicCacheMode)) {
             std::cout << "Menu music loaded!" << std::endl;
         }
         
         // Load game music
-        gameMusic = Mix_LoadMUS("music/background.mp3");
-        if (!gameMusic) {
-            std::cout << "Could not load music/background.mp3: " << Mix_GetError() << std::endl;
-        } else {
+        if (gameMusic.load("music/background.mp3", musicCacheMode)) {
             std::cout << "Game music loaded!" << std::endl;
         }
     }
@@ -328,29 +693,31 @@ public:
     void loadGunAssets() {
         std::cout << "Loading gun sprites and sounds..." << std::endl;
         
-        // Gun sprite filenames
-        std::vector<std::string> gunFiles = {
-            "gun/gun_idle.png",   // Frame 0 - Idle
-            "gun/gun_fire1.png",  // Frame 1 - Fire frame 1
-            "gun/gun_fire2.png",  // Frame 2 - Fire frame 2
-            "gun/gun_fire3.png"   // Frame 3 - Fire frame 3
-        };
-        
         // Load gun sprites
         for (int i = 0; i < GUN_FRAMES; i++) {
-            SDL_Surface* surface = IMG_Load(gunFiles[i].c_str());
+            SDL_Surface* surface = loadImage(GUN_SPRITE_FILES[i]);
             if (surface) {
-                gunSprites[i] = SDL_CreateTextureFromSurface(renderer, surface);
+                if (renderer) {
+                    gunSprites[i] = SDL_CreateTextureFromSurface(renderer, surface);
+                    countStat(STAT_TEXTURE_CREATIONS);
+                }
+                gunWidths[i] = surface->w;
+                gunHeights[i] = surface->h;
+                
+                // Gun is drawn at twice its size
+                spriteFromSurface(surface, 2, gunFrames[i]);
                 SDL_FreeSurface(surface);
-                if (gunSprites[i]) {
-                    std::cout << "Loaded gun sprite: " << gunFiles[i] << std::endl;
+                if (gunSprites[i] || !gunFrames[i].pixels.empty()) {
+                    std::cout << "Loaded gun sprite: " << GUN_SPRITE_FILES[i] << std::endl;
                 }
             }
         }
         
         // Load shoot sound
-        if (musicEnabled) {
-            shootSound = Mix_LoadWAV("sounds/shoot.wav");
+        if (musicEnabled && sampleBank.begin()) {
+            int shootIndex = sampleBank.load(SHOOT_SOUND_FILE, openAsset(SHOOT_SOUND_FILE));
+            sampleBank.finish();
+            shootSound = sampleBank.chunk(shootIndex);
             if (shootSound) {
                 std::cout << "Gun sound loaded!" << std::endl;
                 Mix_VolumeChunk(shootSound, 64);
@@ -358,32 +725,65 @@ public:
         }
     }
     
-    void playMusic(Mix_Music* music) {
-        if (musicEnabled && music) {
-            Mix_HaltMusic();
-            if (Mix_PlayMusic(music, -1) == -1) {
-                std::cout << "Could not play music: " << Mix_GetError() << std::endl;
-            } else {
-                Mix_VolumeMusic(64);
-            }
+    void playMusic(CachedMusic& music) {
+        if (musicEnabled && music.isLoaded()) {
+            music.play(MUSIC_CHANNEL, 64);
+            currentMusic = &music;
         }
     }
     
     void startNewGame() {
         // Reset player position
-        posX = 22.0; posY = 12.0;
+        posX = world.spawnX(); posY = world.spawnY();
         dirX = -1.0; dirY = 0.0;
         planeX = 0.0; planeY = 0.66;
         cameraHeight = GROUND_HEIGHT;
         verticalVelocity = 0.0;
         isJumping = false;
         
+        placeTestEmitters();
+        
         // Switch to game state and music
         currentState = STATE_PLAYING;
         playMusic(gameMusic);
         std::cout << "Starting new game!" << std::endl;
     }
     
+    // Scatter testEmitterCount emitters over empty cells within earshot of the spawn (same layout every run)
+    void placeTestEmitters() {
+        testEmitters.clear();
+        if (testEmitterCount <= 0) return;
+        
+        srand(1);
+        Uint32 now = SDL_GetTicks();
+        int range = (int)SOUND_MAX_DISTANCE / 2;
+        for (int attempt = 0; attempt < testEmitterCount * 100 && (int)testEmitters.size() < testEmitterCount; attempt++) {
+            int x = (int)world.spawnX() + rand() % (2 * range + 1) - range;
+            int y = (int)world.spawnY() + rand() % (2 * range + 1) - range;
+            if (!world.contains(x, y) || world.cell(x, y) != 0) continue;
+            
+            TestEmitter emitter;
+            emitter.x = x + 0.5;
+            emitter.y = y + 0.5;
+            emitter.nextShot = now + rand() % TEST_EMITTER_MAX_INTERVAL;
+            testEmitters.push_back(emitter);
+        }
+        std::cout << "Placed " << testEmitters.size() << " test sound emitters" << std::endl;
+    }
+    
+    void updateSoundSources() {
+        Uint32 now = SDL_GetTicks();
+        for (size_t i = 0; i < testEmitters.size(); i++) {
+            TestEmitter& emitter = testEmitters[i];
+            if ((int)(now - emitter.nextShot) < 0) continue;
+            
+            spatialAudio.playAt(MapWalls(world, pvs), shootSound, emitter.x, emitter.y, 64);
+            emitter.nextShot = now + TEST_EMITTER_MIN_INTERVAL +
+                               rand() % (TEST_EMITTER_MAX_INTERVAL - TEST_EMITTER_MIN_INTERVAL);
+        }
+        spatialAudio.update(MapWalls(world, pvs), posX, posY, dirX, dirY, planeX, planeY);
+    }
+    
     void returnToMenu() {
         currentState = STATE_MENU;
         selectedMenuItem = MENU_NEW_GAME;
@@ -391,15 +791,94 @@ public:
         std::cout << "Returned to main menu" << std::endl;
     }
     
-    inline Uint32 getTexturePixel(int textureNum, int texX, int texY) {
-        texX &= (TEXTURE_WIDTH - 1);
-        texY &= (TEXTURE_HEIGHT - 1);
-        
-        if (textureNum < 1 || textureNum >= NUM_TEXTURES) {
-            return 0xFFFF00FF; // Magenta
+    /**
+     * Textured wall column for one texture size. TexSizeLog2 is a template
+     * parameter so every instantiation keeps constant shifts and masks in the
+     * inner loop; drawWallColumn picks the instantiation per texture.
+     */
+    template<int TexSizeLog2>
+    void drawWallColumnSized(int x, const Uint32* pixels, double wallX, int side, double rayDirX, double rayDirY,
+                             int lineHeight, int drawStart, int drawEnd, int horizon) {
+        const int size = 1 << TexSizeLog2;
+        const int mask = size - 1;
+        
+        int texX = int(wallX * double(size));
+        if (side == 0 && rayDirX > 0) texX = size - texX - 1;
+        if (side == 1 && rayDirY < 0) texX = size - texX - 1;
+        const Uint32* column = pixels + (texX & mask);
+        
+        double step = 1.0 * size / lineHeight;
+        double texPos = (drawStart - horizon + lineHeight / 2) * step;
+        
+        for (int y = drawStart; y < drawEnd; y++) {
+            int texY = (int)texPos & mask;
+            texPos += step;
+            
+            Uint32 color = column[texY << TexSizeLog2];
+            
+            if (side == 1) {
+                color = ((color >> 1) & 0x7F7F7F7F) | 0xFF000000;
+            }
+            
+            screenBuffer[y * SCREEN_WIDTH + x] = color;
+        }
+    }
+    
+    // Fog rises smoothly from FOG_START to fully opaque at the view distance
+    void buildFogLut() {
+        for (int i = 0; i < FOG_LUT_SIZE; i++) {
+            double t = (i / double(FOG_LUT_SIZE - 1) - FOG_START) / (1.0 - FOG_START);
+            if (t < 0) t = 0;
+            if (t > 1) t = 1;
+            fogLut[i] = (Uint16)(t * t * (3 - 2 * t) * 256 + 0.5);
+        }
+    }
+    
+    int fogWeight(double distance) const {
+        int index = (int)(distance / viewDistance * (FOG_LUT_SIZE - 1));
+        return fogLut[index < FOG_LUT_SIZE ? index : FOG_LUT_SIZE - 1];
+    }
+    
+    // Blend a drawn wall column toward the sky above the horizon and the floor below
+    void applyFog(int x, int drawStart, int drawEnd, int horizon, int weight) {
+        Uint32 keep = 256 - weight;
+        Uint32 skyRB = (SKY_COLOR & 0xFF00FF) * weight, skyG = (SKY_COLOR & 0x00FF00) * weight;
+        Uint32 floorRB = (FLOOR_COLOR & 0xFF00FF) * weight, floorG = (FLOOR_COLOR & 0x00FF00) * weight;
+        
+        for (int y = drawStart; y < drawEnd; y++) {
+            Uint32 color = screenBuffer[y * SCREEN_WIDTH + x];
+            Uint32 rb = (color & 0xFF00FF) * keep + (y < horizon ? skyRB : floorRB);
+            Uint32 g = (color & 0x00FF00) * keep + (y < horizon ? skyG : floorG);
+            screenBuffer[y * SCREEN_WIDTH + x] = 0xFF000000 | ((rb >> 8) & 0xFF00FF) | ((g >> 8) & 0x00FF00);
+        }
+        countStat(STAT_FILL_PIXELS, std::max(0, drawEnd - drawStart));
+    }
+    
+    void drawWallColumn(int x, int texNum, double wallX, int side, double rayDirX, double rayDirY,
+                        int lineHeight, int drawStart, int drawEnd, int horizon) {
+        if (texNum < 1 || texNum >= NUM_TEXTURES) {
+            texNum = 0; // Solid magenta
         }
         
-        return texture[textureNum][TEXTURE_WIDTH * texY + texX];
+        // One texel fetch per wall pixel
+        countStat(STAT_WALL_PIXELS, std::max(0, drawEnd - drawStart));
+        countStat(STAT_TEXELS, std::max(0, drawEnd - drawStart));
+        
+        const Uint32* pixels = texture[texNum];
+        switch (textureSize[texNum]) {
+            case 32:
+                drawWallColumnSized<5>(x, pixels, wallX, side, rayDirX, rayDirY, lineHeight, drawStart, drawEnd, horizon);
+                break;
+            case 128:
+                drawWallColumnSized<7>(x, pixels, wallX, side, rayDirX, rayDirY, lineHeight, drawStart, drawEnd, horizon);
+                break;
+            case 256:
+                drawWallColumnSized<8>(x, pixels, wallX, side, rayDirX, rayDirY, lineHeight, drawStart, drawEnd, horizon);
+                break;
+            default:
+                drawWallColumnSized<6>(x, pixels, wallX, side, rayDirX, rayDirY, lineHeight, drawStart, drawEnd, horizon);
+                break;
+        }
     }
     
     bool init() {
@@ -422,7 +901,7 @@ public:
         }
         
         // Initialize SDL_mixer
-        if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+        if (!openAudio(audioBuffer)) {
             std::cerr << "SDL_mixer initialization failed: " << Mix_GetError() << std::endl;
             musicEnabled = false;
         } else {
@@ -439,24 +918,99 @@ public:
             return false;
         }
         
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-        if (!renderer) {
-            std::cerr << "Renderer creation failed: " << SDL_GetError() << std::endl;
-            return false;
+#ifdef MAZE_XSHM
+        if (presentBackend == PRESENT_XSHM && !initXShm()) {
+            std::cout << "MIT-SHM unavailable - using SDL presentation" << std::endl;
+            presentBackend = PRESENT_AUTO;
+        }
+#else
+        if (presentBackend == PRESENT_XSHM) {
+            std::cout << "Built without MIT-SHM support (make xshm) - using SDL presentation" << std::endl;
+            presentBackend = PRESENT_AUTO;
+        }
+#endif
+        
+        if (presentBackend == PRESENT_AUTO || presentBackend == PRESENT_RENDERER) {
+            renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            if (!renderer) {
+                std::cerr << "Renderer creation failed: " << SDL_GetError() << std::endl;
+                if (presentBackend == PRESENT_RENDERER) {
+                    return false;
+                }
+                std::cout << "No accelerated renderer - presenting through the window surface" << std::endl;
+            }
         }
         
-        // Create screen texture for fast pixel buffer rendering
-        screenTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, 
-                                        SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
-        if (!screenTexture) {
-            std::cerr << "Screen texture creation failed: " << SDL_GetError() << std::endl;
-            return false;
+        if (presentBackend == PRESENT_XSHM) {
+            softwareCompositing = true;
+        } else if (renderer) {
+            presentBackend = PRESENT_RENDERER;
+            
+            SDL_RendererInfo rendererInfo;
+            if (SDL_GetRendererInfo(renderer, &rendererInfo) == 0 && (rendererInfo.flags & SDL_RENDERER_SOFTWARE)) {
+                softwareCompositing = true;
+            }
+            
+            // Create screen texture for fast pixel buffer rendering
+            screenTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, 
+                                            SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
+            countStat(STAT_TEXTURE_CREATIONS);
+            if (!screenTexture) {
+                std::cerr << "Screen texture creation failed: " << SDL_GetError() << std::endl;
+                return false;
+            }
+        } else {
+            presentBackend = PRESENT_SURFACE;
+            softwareCompositing = true;
+            
+            windowSurface = SDL_GetWindowSurface(window);
+            if (!windowSurface) {
+                std::cerr << "Window surface creation failed: " << SDL_GetError() << std::endl;
+                return false;
+            }
+            std::cout << "Window surface format: " << SDL_GetPixelFormatName(windowSurface->format->format) << std::endl;
+        }
+        
+        if (softwareCompositing) {
+            std::cout << "HUD is composited in software" << std::endl;
         }
         
         // Allocate screen buffer
-        screenBuffer = new Uint32[SCREEN_WIDTH * SCREEN_HEIGHT];
+        ownedScreenBuffer = new Uint32[SCREEN_WIDTH * SCREEN_HEIGHT];
+        screenBuffer = ownedScreenBuffer;
+#ifdef MAZE_XSHM
+        if (presentBackend == PRESENT_XSHM && xshmPresenter.pitch() == SCREEN_WIDTH) {
+            // Render straight into the shared image
+            screenBuffer = xshmPresenter.pixels();
+        }
+#endif
+        
+        screenshots.start(SCREEN_WIDTH, SCREEN_HEIGHT);
+        
+        if (!statsCsvPath.empty()) {
+            if (engineStats.openCsv(statsCsvPath)) {
+                std::cout << "Writing frame stats to " << statsCsvPath << std::endl;
+            } else {
+                std::cout << "Could not open " << statsCsvPath << std::endl;
+            }
+        }
+        
+        if (!recordPath.empty()) {
+            if (recorder.start(recordPath, SCREEN_WIDTH, SCREEN_HEIGHT, 60)) {
+                std::cout << "Recording to " << recordPath << std::endl;
+            }
+        }
+        
+#ifndef _WIN32
+        if (!frameRingName.empty()) {
+            if (frameRing.create(frameRingName, SCREEN_WIDTH, SCREEN_HEIGHT, FRAME_RING_SLOTS)) {
+                std::cout << "Publishing frames to shared memory " << frameRingName << std::endl;
+            }
+        }
+#endif
         
         // Load all assets
+        loadMap();
         loadFonts();
         loadMusic();
         loadGunAssets();
@@ -468,6 +1022,64 @@ public:
         return true;
     }
     
+    bool openAudio(int bufferFrames) {
+        if (Mix_OpenAudio(audioRate, MIX_DEFAULT_FORMAT, 2, bufferFrames) < 0) {
+            return false;
+        }
+        audioBuffer = bufferFrames;
+        
+        int frequency;
+        Uint16 format;
+        int channels;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        std::cout << "Audio: " << frequency << " Hz, " << bufferFrames << " frame buffer ("
+                  << bufferFrames * 1000.0 / frequency << " ms)" << std::endl;
+        
+        // Decoded music plays on a channel sound effects never take
+        if (musicCacheMode != MUSIC_CACHE_OFF) {
+            Mix_ReserveChannels(1);
+        }
+        audioMonitor.install(frequency, bufferFrames);
+        latencyProbe.setBuffer(frequency, bufferFrames);
+        if (latencyTest) {
+            voiceMixer.setStartListener(LatencyProbe::voiceStarted, &latencyProbe);
+        }
+        voiceMixer.attach();
+        return true;
+    }
+    
+    /**
+     * Once a second, reopen the device with twice the buffer if it kept
+     * running dry. Loaded sounds stay valid since the format is unchanged;
+     * the current music restarts. If the larger buffer is refused the old
+     * size is reopened and kept; if that fails too, sound is turned off.
+     */
+    void checkAudioUnderruns() {
+        Uint32 now = SDL_GetTicks();
+        if (!musicEnabled || now - lastUnderrunCheck < UNDERRUN_CHECK_INTERVAL) return;
+        lastUnderrunCheck = now;
+        
+        Uint32 underruns = audioMonitor.takeUnderruns();
+        if (underruns < UNDERRUN_LIMIT || audioBuffer >= MAX_AUDIO_BUFFER || audioBufferCapped) return;
+        
+        std::cout << underruns << " audio underruns in the last second - growing the buffer" << std::endl;
+        int previousBuffer = audioBuffer;
+        // openAudio() attaches the mixer again once the device is back
+        voiceMixer.detach();
+        Mix_CloseAudio();
+        if (!openAudio(previousBuffer * 2)) {
+            std::cerr << "Could not reopen audio with a larger buffer: " << Mix_GetError() << std::endl;
+            if (!openAudio(previousBuffer)) {
+                std::cerr << "Could not reopen audio - sound disabled: " << Mix_GetError() << std::endl;
+                musicEnabled = false;
+                return;
+            }
+            // Keep the old size rather than retrying every second
+            audioBufferCapped = true;
+        }
+        playMusic(currentState == STATE_PLAYING ? gameMusic : menuMusic);
+    }
+    
     void handleMenuEvents(SDL_Event& e) {
         if (e.type == SDL_KEYDOWN) {
             switch (e.key.keysym.scancode) {
@@ -501,7 +1113,21 @@ public:
         lastAnimationTime = SDL_GetTicks();
         
         if (shootSound && musicEnabled) {
-            Mix_PlayChannel(-1, shootSound, 0);
+            if (latencyTest) {
+                // Keep the mixer from running between play and probe setup
+                Uint64 keyTicks = SDL_GetPerformanceCounter();
+                SDL_LockAudio();
+                if (voiceMixer.isAttached()) {
+                    latencyProbe.onShootVoice(keyTicks, voiceMixer.play(shootSound, 64));
+                } else {
+                    latencyProbe.onShoot(keyTicks, Mix_PlayChannel(-1, shootSound, 0));
+                }
+                SDL_UnlockAudio();
+            } else if (voiceMixer.isAttached()) {
+                voiceMixer.play(shootSound, 64);
+            } else {
+                Mix_PlayChannel(-1, shootSound, 0);
+            }
         }
         
         std::cout << "BANG!" << std::endl;
@@ -551,6 +1177,19 @@ public:
             if (e.key.keysym.scancode == SDL_SCANCODE_X && !isShooting) {
                 shootGun();
             }
+            
+            if (e.key.keysym.scancode == SDL_SCANCODE_F12) {
+                screenshotRequested = true;
+            }
+            
+            if (e.key.keysym.scancode == SDL_SCANCODE_F4 && !e.key.repeat) {
+                statsOverlay = !statsOverlay;
+            }
+            
+            if (e.key.keysym.scancode == SDL_SCANCODE_F3 && !e.key.repeat) {
+                stepView = !stepView;
+                std::cout << "Step view " << (stepView ? "on" : "off") << std::endl;
+            }
         }
         else if (e.type == SDL_KEYUP) {
             keys[e.key.keysym.scancode] = false;
@@ -575,22 +1214,22 @@ public:
         if (currentState == STATE_PLAYING) {
             // Movement
             if (keys[SDL_SCANCODE_W]) {
-                if (worldMap[int(posX + dirX * MOVE_SPEED)][int(posY)] == 0) posX += dirX * MOVE_SPEED;
-                if (worldMap[int(posX)][int(posY + dirY * MOVE_SPEED)] == 0) posY += dirY * MOVE_SPEED;
+                if (world.cell(int(posX + dirX * MOVE_SPEED), int(posY)) == 0) posX += dirX * MOVE_SPEED;
+                if (world.cell(int(posX), int(posY + dirY * MOVE_SPEED)) == 0) posY += dirY * MOVE_SPEED;
             }
             if (keys[SDL_SCANCODE_S]) {
-                if (worldMap[int(posX - dirX * MOVE_SPEED)][int(posY)] == 0) posX -= dirX * MOVE_SPEED;
-                if (worldMap[int(posX)][int(posY - dirY * MOVE_SPEED)] == 0) posY -= dirY * MOVE_SPEED;
+                if (world.cell(int(posX - dirX * MOVE_SPEED), int(posY)) == 0) posX -= dirX * MOVE_SPEED;
+                if (world.cell(int(posX), int(posY - dirY * MOVE_SPEED)) == 0) posY -= dirY * MOVE_SPEED;
             }
             
             // Strafing
             if (keys[SDL_SCANCODE_A]) {
-                if (worldMap[int(posX - planeX * MOVE_SPEED)][int(posY)] == 0) posX -= planeX * MOVE_SPEED;
-                if (worldMap[int(posX)][int(posY - planeY * MOVE_SPEED)] == 0) posY -= planeY * MOVE_SPEED;
+                if (world.cell(int(posX - planeX * MOVE_SPEED), int(posY)) == 0) posX -= planeX * MOVE_SPEED;
+                if (world.cell(int(posX), int(posY - planeY * MOVE_SPEED)) == 0) posY -= planeY * MOVE_SPEED;
             }
             if (keys[SDL_SCANCODE_D]) {
-                if (worldMap[int(posX + planeX * MOVE_SPEED)][int(posY)] == 0) posX += planeX * MOVE_SPEED;
-                if (worldMap[int(posX)][int(posY + planeY * MOVE_SPEED)] == 0) posY += planeY * MOVE_SPEED;
+                if (world.cell(int(posX + planeX * MOVE_SPEED), int(posY)) == 0) posX += planeX * MOVE_SPEED;
+                if (world.cell(int(posX), int(posY + planeY * MOVE_SPEED)) == 0) posY += planeY * MOVE_SPEED;
             }
             
             // Rotation
@@ -625,6 +1264,9 @@ public:
             
             // Update gun animation
             updateGunAnimation();
+            
+            pollVisibilityBuild();
+            updateSoundSources();
         }
     }
     
@@ -634,6 +1276,7 @@ public:
         SDL_Surface* textSurface = TTF_RenderText_Solid(font, text.c_str(), color);
         if (textSurface) {
             SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+            countStat(STAT_TEXTURE_CREATIONS);
             if (textTexture) {
                 SDL_Rect textRect;
                 textRect.w = textSurface->w;
@@ -648,22 +1291,169 @@ public:
                 }
                 
                 SDL_RenderCopy(renderer, textTexture, nullptr, &textRect);
+                countStat(STAT_DRAW_CALLS);
                 SDL_DestroyTexture(textTexture);
             }
             SDL_FreeSurface(textSurface);
         }
     }
     
-    void renderMenu() {
-        // Clear screen first
-        SDL_SetRenderDrawColor(renderer, 20, 30, 50, 255);
-        SDL_RenderClear(renderer);
+    /**
+     * Blend text into screenBuffer. Rasterized strings are cached, so static
+     * HUD text is only rendered by SDL_ttf once.
+     */
+    void blendText(TTF_Font* font, const std::string& text, int x, int y, SDL_Color color, bool centered = false) {
+        if (!font) return;
         
-        // Render background image if available
-        if (menuBackground) {
-            // Scale background to fit screen
-            SDL_Rect backgroundRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-            SDL_RenderCopy(renderer, menuBackground, NULL, &backgroundRect);
+        std::stringstream key;
+        key << font << ':' << (int)color.r << ',' << (int)color.g << ',' << (int)color.b << ',' << (int)color.a << ':' << text;
+        
+        std::map<std::string, Sprite>::iterator it = textSprites.find(key.str());
+        if (it == textSprites.end()) {
+            SDL_Surface* textSurface = TTF_RenderText_Solid(font, text.c_str(), color);
+            if (!textSurface) return;
+            
+            // Keep the cache bounded
+            if (textSprites.size() >= 64) {
+                textSprites.clear();
+            }
+            
+            Sprite sprite;
+            spriteFromSurface(textSurface, 1, sprite);
+            SDL_FreeSurface(textSurface);
+            it = textSprites.insert(std::make_pair(key.str(), sprite)).first;
+        }
+        
+        const Sprite& sprite = it->second;
+        if (centered) {
+            x -= sprite.width / 2;
+            y -= sprite.height / 2;
+        }
+        blendSprite(screenBuffer, SCREEN_WIDTH, SCREEN_HEIGHT, sprite, x, y);
+    }
+    
+    void drawText(TTF_Font* font, const std::string& text, int x, int y, SDL_Color color, bool centered = false) {
+        if (softwareCompositing) {
+            blendText(font, text, x, y, color, centered);
+        } else {
+            renderText(font, text, x, y, color, centered);
+        }
+    }
+    
+#ifdef MAZE_XSHM
+    bool initXShm() {
+        SDL_SysWMinfo info;
+        SDL_VERSION(&info.version);
+        if (!SDL_GetWindowWMInfo(window, &info) || info.subsystem != SDL_SYSWM_X11) {
+            std::cerr << "MIT-SHM backend needs an X11 window" << std::endl;
+            return false;
+        }
+        return xshmPresenter.init(info.info.x11.display, info.info.x11.window, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+#endif
+    
+    const char* presentBackendName() const {
+        switch (presentBackend) {
+            case PRESENT_SURFACE: return "window surface";
+            case PRESENT_XSHM: return "MIT-SHM";
+            default: return softwareCompositing ? "SDL renderer (composited)" : "SDL renderer";
+        }
+    }
+    
+    // A screenshot, recording or frame ring will copy this frame
+    bool capturingFrames() const {
+#ifndef _WIN32
+        if (frameRing.isOpen()) return true;
+#endif
+        return screenshotRequested || recorder.isRecording();
+    }
+
+    /**
+     * Called once per game frame when screenBuffer holds the finished image,
+     * right before it is presented.
+     */
+    void onFrameCompleted() {
+        if (screenshotRequested) {
+            screenshots.capture(screenBuffer);
+            screenshotRequested = false;
+        }
+        
+        if (recorder.isRecording()) {
+            recorder.submitFrame(screenBuffer);
+        }
+        
+#ifndef _WIN32
+        if (frameRing.isOpen()) {
+            Uint64 timestampUs = SDL_GetPerformanceCounter() * 1000000 / SDL_GetPerformanceFrequency();
+            frameRing.publish(screenBuffer, timestampUs);
+        }
+#endif
+    }
+    
+    void recordPresentTime(Uint64 start) {
+        presentTime += SDL_GetPerformanceCounter() - start;
+        presentCount++;
+    }
+    
+    /**
+     * Show screenBuffer as the whole frame.
+     */
+    void presentBuffer() {
+        Uint64 start = SDL_GetPerformanceCounter();
+        
+#ifdef MAZE_XSHM
+        if (presentBackend == PRESENT_XSHM) {
+            if (screenBuffer != xshmPresenter.pixels()) {
+                // Padded image rows: copy instead of rendering in place
+                for (int y = 0; y < SCREEN_HEIGHT; y++) {
+                    memcpy(xshmPresenter.pixels() + y * xshmPresenter.pitch(), screenBuffer + y * SCREEN_WIDTH,
+                           SCREEN_WIDTH * sizeof(Uint32));
+                }
+            }
+            xshmPresenter.present();
+            countStat(STAT_DRAW_CALLS);
+            recordPresentTime(start);
+            return;
+        }
+#endif
+        
+        if (presentBackend == PRESENT_SURFACE) {
+            SDL_LockSurface(windowSurface);
+            convertFrameToSurface(screenBuffer, SCREEN_WIDTH, SCREEN_HEIGHT, windowSurface);
+            SDL_UnlockSurface(windowSurface);
+            SDL_UpdateWindowSurface(window);
+            countStat(STAT_DRAW_CALLS);
+        } else {
+            SDL_UpdateTexture(screenTexture, NULL, screenBuffer, SCREEN_WIDTH * sizeof(Uint32));
+            SDL_RenderCopy(renderer, screenTexture, NULL, NULL);
+            SDL_RenderPresent(renderer);
+            countStat(STAT_DRAW_CALLS, 3);
+        }
+        recordPresentTime(start);
+    }
+    
+    void renderMenu() {
+        if (softwareCompositing) {
+            // Background image if available, otherwise the clear color
+            if (!menuBackgroundPixels.empty()) {
+                memcpy(screenBuffer, menuBackgroundPixels.data(), SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(Uint32));
+            } else {
+                std::fill(screenBuffer, screenBuffer + SCREEN_WIDTH * SCREEN_HEIGHT, 0xFF141E32);
+            }
+            countStat(STAT_FILL_PIXELS, SCREEN_WIDTH * SCREEN_HEIGHT);
+        } else {
+            // Clear screen first
+            SDL_SetRenderDrawColor(renderer, 20, 30, 50, 255);
+            SDL_RenderClear(renderer);
+            countStat(STAT_DRAW_CALLS);
+            
+            // Render background image if available
+            if (menuBackground) {
+                // Scale background to fit screen
+                SDL_Rect backgroundRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+                SDL_RenderCopy(renderer, menuBackground, NULL, &backgroundRect);
+                countStat(STAT_DRAW_CALLS);
+            }
         }
         
         // Colors (made more vibrant to stand out over background)
@@ -676,12 +1466,12 @@ public:
         SDL_Color shadowColor = {0, 0, 0, 255}; // Black shadow
         
         // Render title with shadow
-        renderText(titleFont, "Maze Shooter", SCREEN_WIDTH / 2 + 2, 152, shadowColor, true); // Shadow
-        renderText(titleFont, "Maze Shooter", SCREEN_WIDTH / 2, 150, titleColor, true);     // Main text
+        drawText(titleFont, "Maze Shooter", SCREEN_WIDTH / 2 + 2, 152, shadowColor, true); // Shadow
+        drawText(titleFont, "Maze Shooter", SCREEN_WIDTH / 2, 150, titleColor, true);     // Main text
         
         // Render copyright with shadow
-        renderText(copyrightFont, "Developed by Ahmed Dajani (c) 2025", SCREEN_WIDTH / 2 + 1, 201, shadowColor, true); // Shadow
-        renderText(copyrightFont, "Developed by Ahmed Dajani (c) 2025", SCREEN_WIDTH / 2, 200, copyrightColor, true);   // Main text
+        drawText(copyrightFont, "Developed by Ahmed Dajani (c) 2025", SCREEN_WIDTH / 2 + 1, 201, shadowColor, true); // Shadow
+        drawText(copyrightFont, "Developed by Ahmed Dajani (c) 2025", SCREEN_WIDTH / 2, 200, copyrightColor, true);   // Main text
         
         // Render menu items with color-based selection and shadows
         std::vector<std::string> menuItems = {"New Game", "Exit"};
@@ -691,15 +1481,20 @@ public:
             int y = 300 + i * 60;
             
             // Render shadow first, then main text
-            renderText(menuFont, menuItems[i], SCREEN_WIDTH / 2 + 2, y + 2, shadowColor, true); // Shadow
-            renderText(menuFont, menuItems[i], SCREEN_WIDTH / 2, y, color, true);               // Main text
+            drawText(menuFont, menuItems[i], SCREEN_WIDTH / 2 + 2, y + 2, shadowColor, true); // Shadow
+            drawText(menuFont, menuItems[i], SCREEN_WIDTH / 2, y, color, true);               // Main text
         }
         
         // Instructions with shadow
-        renderText(copyrightFont, "Use Arrow Keys to navigate, Space to select", SCREEN_WIDTH / 2 + 1, 501, shadowColor, true); // Shadow
-        renderText(copyrightFont, "Use Arrow Keys to navigate, Space to select", SCREEN_WIDTH / 2, 500, normalColor, true);     // Main text
+        drawText(copyrightFont, "Use Arrow Keys to navigate, Space to select", SCREEN_WIDTH / 2 + 1, 501, shadowColor, true); // Shadow
+        drawText(copyrightFont, "Use Arrow Keys to navigate, Space to select", SCREEN_WIDTH / 2, 500, normalColor, true);     // Main text
         
-        SDL_RenderPresent(renderer);
+        if (softwareCompositing) {
+            presentBuffer();
+        } else {
+            SDL_RenderPresent(renderer);
+            countStat(STAT_DRAW_CALLS);
+        }
     }
     
     void updateFPS() {
@@ -708,105 +1503,272 @@ public:
         
         if (currentTime - lastTime >= 1000) {
             fps = frameCount * 1000.0 / (currentTime - lastTime);
+            raysPerFrame = (double)raysTraced / frameCount;
+            columnsPerFrame = (double)columnsDrawn / frameCount;
+            raysTraced = 0;
+            columnsDrawn = 0;
             frameCount = 0;
             lastTime = currentTime;
         }
     }
     
-    void drawFPS() {
-        std::stringstream ss;
-        ss << "FPS: " << (int)fps;
-        SDL_Color fpsColor = {255, 255, 255, 255};
-        renderText(copyrightFont, ss.str(), 10, 10, fpsColor);
+    // HUD text from the glyph cache, blended into screenBuffer or drawn by the renderer
+    void drawHudText(bool composite, const char* text, int x, int y) {
+        if (composite) {
+            hudText.blend(screenBuffer, SCREEN_WIDTH, SCREEN_HEIGHT, text, x, y);
+        } else {
+            hudText.render(renderer, text, x, y);
+        }
     }
     
-    void drawGun() {
-        if (!gunSprites[currentGunFrame]) {
+    void drawFPS(bool composite) {
+        char line[64];
+        snprintf(line, sizeof(line), "FPS: %d", (int)fps);
+        drawHudText(composite, line, 10, 10);
+        
+        // Only meaningful when spans skip columns; otherwise every column is one ray
+        if (wallSpans) {
+            snprintf(line, sizeof(line), "Rays: %d for %d wall columns", (int)raysPerFrame, (int)columnsPerFrame);
+            drawHudText(composite, line, 10, 30);
+        }
+        
+        if (statsOverlay) {
+            drawStats(composite);
+        }
+    }
+    
+    // Last frame's workload counters, two per line
+    void drawStats(bool composite) {
+        for (int i = 0; i < STAT_COUNT; i += 2) {
+            char line[128];
+            snprintf(line, sizeof(line), "%s: %llu  %s: %llu",
+                     ENGINE_STAT_NAMES[i], (unsigned long long)engineStats.frame((EngineStat)i),
+                     ENGINE_STAT_NAMES[i + 1], (unsigned long long)engineStats.frame((EngineStat)(i + 1)));
+            drawHudText(composite, line, 10, 50 + i * 10);
+        }
+    }
+    
+    void drawGun(bool composite) {
+        if (composite) {
+            const Sprite& frame = gunFrames[currentGunFrame];
+            blendSprite(screenBuffer, SCREEN_WIDTH, SCREEN_HEIGHT, frame,
+                        (SCREEN_WIDTH - frame.width) / 2, SCREEN_HEIGHT - frame.height);
             return;
         }
         
-        int gunWidth, gunHeight;
-        SDL_QueryTexture(gunSprites[currentGunFrame], NULL, NULL, &gunWidth, &gunHeight);
+        if (!gunSprites[currentGunFrame]) {
+            return;
+        }
         
-        int scaledWidth = gunWidth * 2;
-        int scaledHeight = gunHeight * 2;
+        int scaledWidth = gunWidths[currentGunFrame] * 2;
+        int scaledHeight = gunHeights[currentGunFrame] * 2;
         
         int gunX = (SCREEN_WIDTH - scaledWidth) / 2;
         int gunY = SCREEN_HEIGHT - scaledHeight;
         
         SDL_Rect gunRect = {gunX, gunY, scaledWidth, scaledHeight};
         SDL_RenderCopy(renderer, gunSprites[currentGunFrame], NULL, &gunRect);
+        countStat(STAT_DRAW_CALLS);
+    }
+    
+    // composite: blend the HUD into screenBuffer instead of drawing it with the renderer
+    void drawHud(bool composite) {
+        drawFPS(composite);
+        drawGun(composite);
+        
+        // Show game instructions
+        drawHudText(composite, "ESC - Return to Menu | WASD - Move | Arrows - Turn | SPACE - Jump | SHIFT - Shoot | F3 - Step View | F4 - Stats | F12 - Screenshot", 10, SCREEN_HEIGHT - 30);
+    }
+    
+    template<bool StepView, typename Map>
+    void traceColumn(Map& map, int x) {
+        double cameraX = 2 * x / double(SCREEN_WIDTH) - 1;
+        double rayDirX = dirX + planeX * cameraX, rayDirY = dirY + planeY * cameraX;
+        if (StepView) {
+            CellVisitCounter counter = {this};
+            columnHits[x] = castRay(map, posX, posY, rayDirX, rayDirY, viewDistance, counter);
+        } else {
+            columnHits[x] = castRay(map, posX, posY, rayDirX, rayDirY, viewDistance);
+        }
+        raysTraced++;
+        countStat(STAT_RAYS);
+        countStat(STAT_DDA_STEPS, columnHits[x].steps);
+    }
+    
+    /**
+     * Widest step between traced columns that a wall cell cannot hide in.
+     * A cell within the view distance is at least
+     * SCREEN_WIDTH / (2 * |plane| * depth) columns wide on screen, so a
+     * narrower gap always has a traced ray through any cell in front of a
+     * face.
+     */
+    int wallSpanColumns() const {
+        double planeLength = std::sqrt(planeX * planeX + planeY * planeY);
+        int span = (int)(SCREEN_WIDTH / (2 * planeLength * (viewDistance + 1.5))) - 1;
+        return std::max(1, std::min(span, MAX_WALL_SPAN));
+    }
+    
+    // Fill the columns strictly between traced columns a and b, bisecting until both ends share a face
+    template<bool StepView, typename Map>
+    void fillWallSpan(Map& map, int a, int b) {
+        if (b - a < 2) return;
+        
+        if (sameFace(columnHits[a], columnHits[b])) {
+            for (int x = a + 1; x < b; x++) {
+                double cameraX = 2 * x / double(SCREEN_WIDTH) - 1;
+                columnHits[x] = faceHit(columnHits[a], posX, posY, dirX + planeX * cameraX, dirY + planeY * cameraX);
+            }
+            return;
+        }
+        int middle = (a + b) / 2;
+        traceColumn<StepView>(map, middle);
+        fillWallSpan<StepView>(map, a, middle);
+        fillWallSpan<StepView>(map, middle, b);
     }
     
+    template<bool StepView, typename Map>
+    void traceColumnsThrough(Map& map) {
+        if (!wallSpans) {
+            for (int x = 0; x < SCREEN_WIDTH; x++) {
+                traceColumn<StepView>(map, x);
+            }
+            return;
+        }
+        
+        int span = wallSpanColumns();
+        traceColumn<StepView>(map, 0);
+        for (int a = 0; a < SCREEN_WIDTH - 1;) {
+            int b = std::min(a + span, SCREEN_WIDTH - 1);
+            traceColumn<StepView>(map, b);
+            fillWallSpan<StepView>(map, a, b);
+            a = b;
+        }
+    }
+    
+    // Traces the frame through the view the world chose for its rays (leaping or not)
+    template<bool StepView>
+    struct ColumnTracer {
+        MazeShooter* game;
+        template<typename Map>
+        void operator()(Map& map) const {
+            game->traceColumnsThrough<StepView>(map);
+        }
+    };
+    
+    template<bool StepView>
+    void traceColumns() {
+        if (StepView) {
+            resetCellVisits();
+        }
+        ColumnTracer<StepView> tracer = {this};
+        world.withRayView(tracer);
+    }
+    
+    // Rays cannot visit cells farther than viewDistance, so a window that size around the player holds them all
+    void resetCellVisits() {
+        visitSize = 2 * (int)std::ceil(viewDistance) + 3;
+        visitOriginX = (int)posX - visitSize / 2;
+        visitOriginY = (int)posY - visitSize / 2;
+        cellVisits.assign((size_t)visitSize * visitSize, 0);
+    }
+    
+    // Blue through green and yellow to red as t goes from 0 to 1
+    static Uint32 heatColor(double t) {
+        static const int stops[4][3] = {{0, 0, 255}, {0, 200, 0}, {255, 220, 0}, {255, 0, 0}};
+        double scaled = std::max(0.0, std::min(1.0, t)) * 3;
+        int i = std::min(2, (int)scaled);
+        double f = scaled - i;
+        Uint32 r = (Uint32)(stops[i][0] + (stops[i + 1][0] - stops[i][0]) * f);
+        Uint32 g = (Uint32)(stops[i][1] + (stops[i + 1][1] - stops[i][1]) * f);
+        Uint32 b = (Uint32)(stops[i][2] + (stops[i + 1][2] - stops[i][2]) * f);
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+    
+    /**
+     * Step view floor: cast each row below the horizon onto the floor and
+     * color it by how many rays visited that cell this frame, on a log
+     * scale up to one visit per screen column.
+     */
+    void drawVisitFloor(int horizon) {
+        double rayDirX0 = dirX - planeX, rayDirY0 = dirY - planeY;
+        double rayDirX1 = dirX + planeX, rayDirY1 = dirY + planeY;
+        double scale = 1.0 / std::log2(1.0 + SCREEN_WIDTH);
+        Uint32 visitColors[STEP_VIEW_COLORS];
+        for (int i = 0; i < STEP_VIEW_COLORS; i++) {
+            visitColors[i] = heatColor(i / double(STEP_VIEW_COLORS - 1));
+        }
+        
+        uint64_t written = 0;
+        for (int y = std::max(horizon + 1, 0); y < SCREEN_HEIGHT; y++) {
+            double rowDistance = SCREEN_HEIGHT / (2.0 * (y - horizon));
+            double floorX = posX + rowDistance * rayDirX0, floorY = posY + rowDistance * rayDirY0;
+            double stepX = rowDistance * (rayDirX1 - rayDirX0) / SCREEN_WIDTH;
+            double stepY = rowDistance * (rayDirY1 - rayDirY0) / SCREEN_WIDTH;
+            Uint32* row = screenBuffer + y * SCREEN_WIDTH;
+            for (int x = 0; x < SCREEN_WIDTH; x++, floorX += stepX, floorY += stepY) {
+                unsigned localX = (int)std::floor(floorX) - visitOriginX, localY = (int)std::floor(floorY) - visitOriginY;
+                if (localX >= (unsigned)visitSize || localY >= (unsigned)visitSize) continue;
+                Uint16 visits = cellVisits[localX * visitSize + localY];
+                if (visits == 0) continue;
+                int level = (int)(std::log2(1.0 + visits) * scale * (STEP_VIEW_COLORS - 1));
+                row[x] = visitColors[std::min(level, STEP_VIEW_COLORS - 1)];
+                written++;
+            }
+        }
+        countStat(STAT_FILL_PIXELS, written);
+    }
+    
+    // Step view wall: blend the drawn column half way toward the heat color of its DDA step count
+    void tintColumn(int x, int drawStart, int drawEnd, int steps) {
+        Uint32 heat = heatColor(steps / double(STEP_VIEW_MAX_STEPS));
+        Uint32 heatRB = (heat & 0xFF00FF) * 128, heatG = (heat & 0x00FF00) * 128;
+        for (int y = drawStart; y < drawEnd; y++) {
+            Uint32 color = screenBuffer[y * SCREEN_WIDTH + x];
+            Uint32 rb = (color & 0xFF00FF) * 128 + heatRB;
+            Uint32 g = (color & 0x00FF00) * 128 + heatG;
+            screenBuffer[y * SCREEN_WIDTH + x] = 0xFF000000 | ((rb >> 8) & 0xFF00FF) | ((g >> 8) & 0x00FF00);
+        }
+        countStat(STAT_FILL_PIXELS, std::max(0, drawEnd - drawStart));
+    }
+    
+    /**
+     * One frame of the 3D view. StepView is a template parameter so the
+     * step view's visit counting and tinting are compiled out of the normal
+     * instantiation; render() picks one per frame.
+     */
+    template<bool StepView>
     void renderGame() {
         updateFPS();
+        world.prefetch(posX, posY, dirX, dirY, planeX, planeY);
         
         int horizon = SCREEN_HEIGHT / 2 + (int)(cameraHeight * 100);
         
         for (int y = 0; y < SCREEN_HEIGHT; y++) {
             for (int x = 0; x < SCREEN_WIDTH; x++) {
                 if (y < horizon) {
-                    screenBuffer[y * SCREEN_WIDTH + x] = 0xFF87CEEB;
+                    screenBuffer[y * SCREEN_WIDTH + x] = SKY_COLOR;
                 } else {
-                    screenBuffer[y * SCREEN_WIDTH + x] = 0xFF555555;
+                    screenBuffer[y * SCREEN_WIDTH + x] = FLOOR_COLOR;
                 }
             }
         }
+        countStat(STAT_FILL_PIXELS, SCREEN_WIDTH * SCREEN_HEIGHT);
         
         // Raycasting for walls
+        traceColumns<StepView>();
+        if (StepView) {
+            drawVisitFloor(horizon);
+        }
         for (int x = 0; x < SCREEN_WIDTH; x++) {
             double cameraX = 2 * x / double(SCREEN_WIDTH) - 1;
             double rayDirX = dirX + planeX * cameraX;
             double rayDirY = dirY + planeY * cameraX;
             
-            int mapX = int(posX);
-            int mapY = int(posY);
-            
-            double deltaDistX = std::abs(1 / rayDirX);
-            double deltaDistY = std::abs(1 / rayDirY);
-            double perpWallDist;
-            
-            int stepX, stepY;
-            double sideDistX, sideDistY;
-            
-            if (rayDirX < 0) {
-                stepX = -1;
-                sideDistX = (posX - mapX) * deltaDistX;
-            } else {
-                stepX = 1;
-                sideDistX = (mapX + 1.0 - posX) * deltaDistX;
-            }
-            
-            if (rayDirY < 0) {
-                stepY = -1;
-                sideDistY = (posY - mapY) * deltaDistY;
-            } else {
-                stepY = 1;
-                sideDistY = (mapY + 1.0 - posY) * deltaDistY;
-            }
-            
-            int hit = 0;
-            int side;
-            
-            while (hit == 0) {
-                if (sideDistX < sideDistY) {
-                    sideDistX += deltaDistX;
-                    mapX += stepX;
-                    side = 0;
-                } else {
-                    sideDistY += deltaDistY;
-                    mapY += stepY;
-                    side = 1;
-                }
-                
-                if (worldMap[mapX][mapY] > 0) hit = 1;
-            }
-            
-            if (side == 0) {
-                perpWallDist = (mapX - posX + (1 - stepX) / 2) / rayDirX;
-            } else {
-                perpWallDist = (mapY - posY + (1 - stepY) / 2) / rayDirY;
-            }
+            const RayHit& hit = columnHits[x];
+            if (hit.cell == 0) continue;  // Nothing within the view distance: fully fogged
+            columnsDrawn++;
+            double perpWallDist = hit.perpWallDist;
+            int side = hit.side;
             
             int lineHeight = (int)(SCREEN_HEIGHT / perpWallDist);
             
@@ -816,7 +1778,7 @@ public:
             int drawEnd = lineHeight / 2 + horizon;
             if (drawEnd >= SCREEN_HEIGHT) drawEnd = SCREEN_HEIGHT - 1;
             
-            int texNum = worldMap[mapX][mapY];
+            int texNum = hit.cell;
             
             double wallX;
             if (side == 0) {
@@ -826,75 +1788,118 @@ public:
             }
             wallX -= floor(wallX);
             
-            int texX = int(wallX * double(TEXTURE_WIDTH));
-            if (side == 0 && rayDirX > 0) texX = TEXTURE_WIDTH - texX - 1;
-            if (side == 1 && rayDirY < 0) texX = TEXTURE_WIDTH - texX - 1;
+            drawWallColumn(x, texNum, wallX, side, rayDirX, rayDirY, lineHeight, drawStart, drawEnd, horizon);
             
-            double step = 1.0 * TEXTURE_HEIGHT / lineHeight;
-            double texPos = (drawStart - horizon + lineHeight / 2) * step;
-            
-            for (int y = drawStart; y < drawEnd; y++) {
-                int texY = (int)texPos & (TEXTURE_HEIGHT - 1);
-                texPos += step;
-                
-                Uint32 color = getTexturePixel(texNum, texX, texY);
-                
-                if (side == 1) {
-                    color = ((color >> 1) & 0x7F7F7F7F) | 0xFF000000;
-                }
-                
-                screenBuffer[y * SCREEN_WIDTH + x] = color;
+            int fog = fogWeight(perpWallDist);
+            if (fog > 0) {
+                applyFog(x, drawStart, drawEnd, horizon, fog);
+            }
+            if (StepView) {
+                tintColumn(x, drawStart, drawEnd, hit.steps);
             }
         }
         
-        SDL_UpdateTexture(screenTexture, NULL, screenBuffer, SCREEN_WIDTH * sizeof(Uint32));
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, screenTexture, NULL, NULL);
-        
-        drawFPS();
-        drawGun();
-        
-        // Show game instructions
-        SDL_Color instructColor = {255, 255, 255, 255};
-        renderText(copyrightFont, "ESC - Return to Menu | WASD - Move | Arrows - Turn | SPACE - Jump | SHIFT - Shoot", 10, SCREEN_HEIGHT - 30, instructColor);
+        if (softwareCompositing || capturingFrames()) {
+            // HUD goes into the frame itself: one upload and one copy per frame.
+            // Captured frames need it there too, so blend it in software for them
+            drawHud(true);
+            onFrameCompleted();
+            presentBuffer();
+        } else {
+            onFrameCompleted();
+            Uint64 start = SDL_GetPerformanceCounter();
+            SDL_UpdateTexture(screenTexture, NULL, screenBuffer, SCREEN_WIDTH * sizeof(Uint32));
+            SDL_RenderClear(renderer);
+            SDL_RenderCopy(renderer, screenTexture, NULL, NULL);
+            drawHud(false);
+            SDL_RenderPresent(renderer);
+            countStat(STAT_DRAW_CALLS, 4);
+            recordPresentTime(start);
+        }
         
-        SDL_RenderPresent(renderer);
+        if (latencyTest) {
+            latencyProbe.onFramePresented(currentGunFrame);
+        }
     }
     
     void render() {
         if (currentState == STATE_MENU) {
             renderMenu();
         } else if (currentState == STATE_PLAYING) {
-            renderGame();
+            if (stepView) {
+                renderGame<true>();
+            } else {
+                renderGame<false>();
+            }
         }
+        engineStats.endFrame();
     }
     
     void run() {
         std::cout << "Maze Shooter Started!" << std::endl;
+        
+        if (benchFrames > 0) {
+            runBenchmark();
+            return;
+        }
+        
         std::cout << "Currently in main menu" << std::endl;
         
         while (running) {
             handleEvents();
             render();
+            checkAudioUnderruns();
+            if (musicEnabled && currentMusic) {
+                currentMusic->update();
+            }
             SDL_Delay(16);
         }
     }
     
-    void cleanup() {
-        if (menuMusic) {
-            Mix_FreeMusic(menuMusic);
-            menuMusic = nullptr;
+    /**
+     * Play benchFrames frames as fast as possible while turning on the spot,
+     * then report frame and present times for the active backend.
+     */
+    void runBenchmark() {
+        startNewGame();
+        presentTime = 0;
+        presentCount = 0;
+        
+        Uint64 start = SDL_GetPerformanceCounter();
+        int frames = 0;
+        while (running && frames < benchFrames) {
+            keys[SDL_SCANCODE_LEFT] = true;
+            handleEvents();
+            render();
+            frames++;
         }
+        double elapsedMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        double presentMs = presentTime * 1000.0 / SDL_GetPerformanceFrequency();
         
-        if (gameMusic) {
-            Mix_FreeMusic(gameMusic);
-            gameMusic = nullptr;
+        std::cout << "Benchmark (" << presentBackendName() << "): " << frames << " frames, "
+                  << elapsedMs / std::max(frames, 1) << " ms/frame, "
+                  << presentMs / std::max((int)presentCount, 1) << " ms/present" << std::endl;
+        running = false;
+    }
+    
+    void cleanup() {
+        if (latencyTest) {
+            latencyProbe.printSummary();
         }
         
-        if (shootSound) {
-            Mix_FreeChunk(shootSound);
-            shootSound = nullptr;
-        }
+        // Voices play straight from the chunks freed below
+        voiceMixer.printStats();
+        spatialAudio.printStats();
+        world.printStats();
+        voiceMixer.detach();
+        stopVisibilityBuild();
+        pvs.clear();
+        
+        menuMusic.free();
+        gameMusic.free();
+        
+        sampleBank.clear();
+        shootSound = nullptr;
         
         for (int i = 0; i < GUN_FRAMES; i++) {
             if (gunSprites[i]) {
@@ -903,18 +1908,30 @@ public:
             }
         }
         
+        hudText.free();
         if (titleFont) TTF_CloseFont(titleFont);
         if (menuFont) TTF_CloseFont(menuFont);
         if (copyrightFont) TTF_CloseFont(copyrightFont);
         
+        // Fonts stream from the mapping, so unmap only after closing them
+        assetPack.close();
+        
         if (menuBackground) {
             SDL_DestroyTexture(menuBackground);
             menuBackground = nullptr;
         }
         
-        if (screenBuffer) {
-            delete[] screenBuffer;
+        recorder.stop();
+        screenshots.stop();
+        
+#ifdef MAZE_XSHM
+        xshmPresenter.shutdown();
+#endif
+        if (ownedScreenBuffer) {
+            delete[] ownedScreenBuffer;
+            ownedScreenBuffer = nullptr;
         }
+        screenBuffer = nullptr;
         if (screenTexture) {
             SDL_DestroyTexture(screenTexture);
         }
@@ -935,26 +1952,169 @@ public:
         std::cout << "Maze Shooter cleaned up. Thanks for playing!" << std::endl;
     }
     
+    void setSoftwareCompositing(bool enabled) {
+        softwareCompositing = enabled;
+    }
+    
+    void setPresentBackend(PresentBackend backend) {
+        presentBackend = backend;
+    }
+    
+    void setBenchmarkFrames(int frames) {
+        benchFrames = frames;
+    }
+    
+    void setAudio(int rate, int bufferFrames) {
+        if (rate > 0) audioRate = rate;
+        if (bufferFrames > 0) audioBuffer = bufferFrames;
+    }
+    
+    void setLatencyTest(bool enabled) {
+        latencyTest = enabled;
+    }
+    
+    void setHrtf(bool enabled) {
+        spatialAudio.setHrtf(enabled);
+    }
+    
+    void setTestEmitters(int count) {
+        testEmitterCount = count;
+    }
+    
+    void setMusicCache(MusicCacheMode mode) {
+        musicCacheMode = mode;
+    }
+    
+    void setMapPath(const std::string& path) {
+        mapPath = path;
+    }
+    
+    void setGeneratedMap(MazeAlgorithm algorithm) {
+        generateMap = true;
+        mazeAlgorithm = algorithm;
+    }
+    
+    void setGeneratedMapSize(int size) {
+        generatedMapSize = size;
+    }
+    
+    void setMazeSeed(uint64_t seed) {
+        mazeSeed = seed;
+    }
+    
+    void setPvs(bool enabled) {
+        pvsEnabled = enabled;
+    }
+    
+    void setWallSpans(bool enabled) {
+        wallSpans = enabled;
+    }
+    
+    void setViewDistance(double distance) {
+        if (distance > 0) {
+            viewDistance = distance;
+        }
+    }
+    
+    void setStatsCsv(const std::string& path) {
+        statsCsvPath = path;
+    }
+    
+    void setRecordPath(const std::string& path) {
+        recordPath = path;
+    }
+    
+#ifndef _WIN32
+    void setFrameRing(const std::string& name) {
+        frameRingName = name;
+    }
+#endif
+    
     ~MazeShooter() {
         cleanup();
     }
 };
 
 int main(int argc, char* argv[]) {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
     MazeShooter game;
     
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--composite") {
+            game.setSoftwareCompositing(true);
+        } else if (arg == "--present=renderer") {
+            game.setPresentBackend(PRESENT_RENDERER);
+        } else if (arg == "--present=surface") {
+            game.setPresentBackend(PRESENT_SURFACE);
+        } else if (arg == "--present=xshm") {
+            game.setPresentBackend(PRESENT_XSHM);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            game.setBenchmarkFrames(atoi(argv[++i]));
+        } else if (arg == "--music-cache=off") {
+            game.setMusicCache(MUSIC_CACHE_OFF);
+        } else if (arg == "--music-cache=memory") {
+            game.setMusicCache(MUSIC_CACHE_MEMORY);
+        } else if (arg == "--music-cache=disk") {
+            game.setMusicCache(MUSIC_CACHE_DISK);
+        } else if (arg == "--audio-rate" && i + 1 < argc) {
+            game.setAudio(atoi(argv[++i]), 0);
+        } else if (arg == "--audio-buffer" && i + 1 < argc) {
+            game.setAudio(0, atoi(argv[++i]));
+        } else if (arg == "--hrtf") {
+            game.setHrtf(true);
+        } else if (arg == "--sound-sources" && i + 1 < argc) {
+            game.setTestEmitters(atoi(argv[++i]));
+        } else if (arg == "--latency-test") {
+            game.setLatencyTest(true);
+        } else if (arg == "--map" && i + 1 < argc) {
+            game.setMapPath(argv[++i]);
+        } else if (arg == "--generate" && i + 1 < argc) {
+            MazeAlgorithm algorithm;
+            if (parseMazeAlgorithm(argv[++i], algorithm)) {
+                game.setGeneratedMap(algorithm);
+            } else {
+                std::cerr << "Unknown maze type: " << argv[i] << " (backtracker, wilson or rooms)" << std::endl;
+            }
+        } else if (arg == "--map-size" && i + 1 < argc) {
+            game.setGeneratedMapSize(atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            game.setMazeSeed(strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--no-pvs") {
+            game.setPvs(false);
+        } else if (arg == "--wall-spans") {
+            game.setWallSpans(true);
+        } else if (arg == "--view-distance" && i + 1 < argc) {
+            game.setViewDistance(atof(argv[++i]));
+        } else if (arg == "--stats-csv" && i + 1 < argc) {
+            game.setStatsCsv(argv[++i]);
+        } else if (arg == "--record" && i + 1 < argc) {
+            game.setRecordPath(argv[++i]);
+#ifndef _WIN32
+        } else if (arg == "--frame-ring") {
+            bool hasName = i + 1 < argc && argv[i + 1][0] == '/';
+            game.setFrameRing(hasName ? argv[++i] : FRAME_RING_DEFAULT_NAME);
+#endif
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+        }
+    }
+    
     if (!game.init()) {
         std::cerr << "Failed to initialize Maze Shooter!" << std::endl;
         return -1;
     }
     
+    double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Startup took " << startupMs << " ms" << std::endl;
+    
     std::cout << "================================" << std::endl;
     std::cout << "MAZE SHOOTER" << std::endl;
     std::cout << "Developed by Ahmed Dajani (c) 2025" << std::endl;
     std::cout << "================================" << std::endl;
     std::cout << std::endl;
     std::cout << "Controls:" << std::endl;
-    std::cout << "WASD - Move, Arrows - Turn, Space - Jump, Shift - Shoot" << std::endl;
+    std::cout << "WASD - Move, Arrows - Turn, Space - Jump, Shift - Shoot, F3 - Step view, F4 - Stats, F12 - Screenshot" << std::endl;
     std::cout << "Press Space to start a new game or Exit to quit." << std::endl;
     std::cout << "Press ESC to return to the main menu." << std::endl;
     std::cout << "================================" << std::endl;
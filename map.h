@@ -0,0 +1,357 @@
+/**
+ * @file map.h
+ * @brief Game maps loaded from editable text files or compact binary files
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Cells are stored as one byte each (0 = empty, 1..255 = wall texture id),
+ * column-major like the original worldMap: cell (x, y) is at x * height + y.
+ *
+ * Text format (.txt): one line per x index, one character per y index.
+ *   0        empty
+ *   1-9      wall with that texture id
+ *   P        empty, player spawn
+ *   # ...    comment line; blank lines are ignored
+ *
+ * Binary format (.msm): a 32-byte MapFileHeader followed by width * height
+ * cell bytes. It is memory-mapped as is, with no parsing.
+ *
+ * Maps must be rectangular and enclosed by walls. No SDL dependency, so
+ * the command-line tools can use it too.
+ */
+
+#ifndef MAP_H
+#define MAP_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char MAP_MAGIC[4] = {'M', 'S', 'M', 'P'};
+const uint32_t MAP_VERSION = 1;
+const uint32_t MAP_MAX_SIZE = 65536;
+
+struct MapFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;     // Cells along x
+    uint32_t height;    // Cells along y
+    float spawnX;
+    float spawnY;
+    uint32_t reserved[2];
+};
+
+static_assert(sizeof(MapFileHeader) == 32, "MapFileHeader layout");
+
+inline bool hasExtension(const std::string& path, const std::string& extension) {
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+class GameMap {
+private:
+    const uint8_t* cells;
+    std::vector<uint8_t> ownedCells;
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    double spawnPosX;
+    double spawnPosY;
+
+    // Mapped binary file, if any
+    void* mapping;
+    size_t mappingSize;
+
+    void release() {
+#ifndef _WIN32
+        if (mapping) {
+            munmap(mapping, mappingSize);
+        }
+#endif
+        mapping = nullptr;
+        mappingSize = 0;
+        ownedCells.clear();
+        cells = nullptr;
+        mapWidth = 0;
+        mapHeight = 0;
+    }
+
+    bool validate(const std::string& source) {
+        for (uint32_t x = 0; x < mapWidth; x++) {
+            for (uint32_t y = 0; y < mapHeight; y++) {
+                bool border = x == 0 || y == 0 || x == mapWidth - 1 || y == mapHeight - 1;
+                if (border && cell(x, y) == 0) {
+                    std::cerr << source << ": map is not enclosed by walls at (" << x << ", " << y << ")" << std::endl;
+                    return false;
+                }
+            }
+        }
+        if (spawnPosX < 0 || spawnPosY < 0 || spawnPosX >= mapWidth || spawnPosY >= mapHeight ||
+            cell((int)spawnPosX, (int)spawnPosY) != 0) {
+            std::cerr << source << ": spawn point is not on an empty cell" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    // Same interface as ChunkedMap::Cursor; off-map cells read as walls
+    class Cursor {
+    private:
+        const GameMap& map;
+
+    public:
+        explicit Cursor(const GameMap& gameMap) : map(gameMap) {}
+
+        bool solid(int x, int y) const {
+            return at(x, y) != 0;
+        }
+
+        uint8_t at(int x, int y) const {
+            return map.contains(x, y) ? map.cell(x, y) : 1;
+        }
+
+        // No occupancy pyramid; rays step cell by cell
+        int emptyShift(int, int) const {
+            return 0;
+        }
+    };
+
+    GameMap() : cells(nullptr), mapWidth(0), mapHeight(0), spawnPosX(0), spawnPosY(0),
+                mapping(nullptr), mappingSize(0) {}
+
+    ~GameMap() {
+        release();
+    }
+
+    int width() const { return (int)mapWidth; }
+    int height() const { return (int)mapHeight; }
+    double spawnX() const { return spawnPosX; }
+    double spawnY() const { return spawnPosY; }
+    const uint8_t* data() const { return cells; }
+
+    bool isLoaded() const {
+        return cells != nullptr;
+    }
+
+    bool contains(int x, int y) const {
+        return x >= 0 && y >= 0 && x < (int)mapWidth && y < (int)mapHeight;
+    }
+
+    // No bounds check; the enclosing walls keep the engine inside
+    uint8_t cell(int x, int y) const {
+        return cells[(size_t)x * mapHeight + y];
+    }
+
+    /**
+     * Take width * height cells (column-major) and a spawn position, e.g.
+     * from a generator. Pass the cells with std::move to avoid a copy.
+     */
+    bool assign(uint32_t width, uint32_t height, std::vector<uint8_t> newCells, double spawnX, double spawnY,
+                const std::string& source) {
+        release();
+        if (width < 3 || height < 3 || newCells.size() != (size_t)width * height) {
+            std::cerr << source << ": invalid map dimensions" << std::endl;
+            return false;
+        }
+        ownedCells.swap(newCells);
+        cells = ownedCells.data();
+        mapWidth = width;
+        mapHeight = height;
+        spawnPosX = spawnX;
+        spawnPosY = spawnY;
+        if (!validate(source)) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    bool parseText(const std::string& text, const std::string& source) {
+        std::vector<std::string> rows;
+        std::istringstream in(text);
+        std::string line;
+        int spawnRow = -1, spawnColumn = -1;
+        while (std::getline(in, line)) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+                line.pop_back();
+            }
+            if (line.empty() || line[0] == '#') continue;
+
+            for (size_t i = 0; i < line.size(); i++) {
+                char c = line[i];
+                if (c == 'P' || c == 'p') {
+                    if (spawnRow >= 0) {
+                        std::cerr << source << ": more than one spawn point" << std::endl;
+                        return false;
+                    }
+                    spawnRow = (int)rows.size();
+                    spawnColumn = (int)i;
+                } else if (c < '0' || c > '9') {
+                    std::cerr << source << ":" << rows.size() + 1 << ": unexpected '" << c << "'" << std::endl;
+                    return false;
+                }
+            }
+            if (!rows.empty() && line.size() != rows[0].size()) {
+                std::cerr << source << ": row " << rows.size() + 1 << " has " << line.size()
+                          << " cells, expected " << rows[0].size() << std::endl;
+                return false;
+            }
+            rows.push_back(line);
+        }
+        if (rows.empty() || rows.size() > MAP_MAX_SIZE || rows[0].size() > MAP_MAX_SIZE) {
+            std::cerr << source << ": no map rows" << std::endl;
+            return false;
+        }
+        if (spawnRow < 0) {
+            std::cerr << source << ": no spawn point (P)" << std::endl;
+            return false;
+        }
+
+        uint32_t width = rows.size();
+        uint32_t height = rows[0].size();
+        std::vector<uint8_t> parsed(width * height);
+        for (uint32_t x = 0; x < width; x++) {
+            for (uint32_t y = 0; y < height; y++) {
+                char c = rows[x][y];
+                parsed[x * height + y] = (c >= '0' && c <= '9') ? c - '0' : 0;
+            }
+        }
+        return assign(width, height, parsed, spawnRow + 0.5, spawnColumn + 0.5, source);
+    }
+
+    bool loadText(const std::string& path) {
+        std::ifstream file(path.c_str());
+        if (!file) {
+            return false;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return parseText(text.str(), path);
+    }
+
+    bool loadBinary(const std::string& path) {
+        release();
+
+        std::vector<uint8_t> fileData;
+        const uint8_t* bytes = nullptr;
+        size_t size = 0;
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MapFileHeader)) {
+            ::close(fd);
+            std::cerr << path << " is not a map file" << std::endl;
+            return false;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map " << path << std::endl;
+            return false;
+        }
+        mapping = mapped;
+        mappingSize = st.st_size;
+        bytes = (const uint8_t*)mapped;
+        size = st.st_size;
+#else
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        ownedCells.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = ownedCells.data();
+        size = ownedCells.size();
+#endif
+
+        const MapFileHeader* header = (const MapFileHeader*)bytes;
+        if (size < sizeof(MapFileHeader) || memcmp(header->magic, MAP_MAGIC, sizeof(MAP_MAGIC)) != 0 ||
+            header->version != MAP_VERSION) {
+            std::cerr << path << " is not a compatible map file" << std::endl;
+            release();
+            return false;
+        }
+        if (header->width < 3 || header->height < 3 || header->width > MAP_MAX_SIZE || header->height > MAP_MAX_SIZE ||
+            sizeof(MapFileHeader) + (size_t)header->width * header->height > size) {
+            std::cerr << path << " is truncated" << std::endl;
+            release();
+            return false;
+        }
+
+        cells = bytes + sizeof(MapFileHeader);
+        mapWidth = header->width;
+        mapHeight = header->height;
+        spawnPosX = header->spawnX;
+        spawnPosY = header->spawnY;
+        if (!validate(path)) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    // .msm files are binary, anything else is text
+    bool load(const std::string& path) {
+        return hasExtension(path, ".msm") ? loadBinary(path) : loadText(path);
+    }
+
+    std::string toText() const {
+        std::string text = "# " + std::to_string(mapWidth) + " x " + std::to_string(mapHeight) + " cells\n";
+        int spawnCellX = (int)spawnPosX, spawnCellY = (int)spawnPosY;
+        for (int x = 0; x < (int)mapWidth; x++) {
+            for (int y = 0; y < (int)mapHeight; y++) {
+                uint8_t value = cell(x, y);
+                if (x == spawnCellX && y == spawnCellY) {
+                    text += 'P';
+                } else {
+                    text += value <= 9 ? (char)('0' + value) : '9';
+                }
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    bool saveText(const std::string& path) const {
+        std::ofstream file(path.c_str());
+        file << toText();
+        return (bool)file;
+    }
+
+    bool saveBinary(const std::string& path) const {
+        MapFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAP_MAGIC, sizeof(MAP_MAGIC));
+        header.version = MAP_VERSION;
+        header.width = mapWidth;
+        header.height = mapHeight;
+        header.spawnX = (float)spawnPosX;
+        header.spawnY = (float)spawnPosY;
+
+        std::ofstream file(path.c_str(), std::ios::binary);
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)cells, (std::streamsize)mapWidth * mapHeight);
+        return (bool)file;
+    }
+
+    bool save(const std::string& path) const {
+        return hasExtension(path, ".msm") ? saveBinary(path) : saveText(path);
+    }
+};
+
+#endif // MAP_H
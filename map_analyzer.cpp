@@ -0,0 +1,402 @@
+/**
+ * @file map_analyzer.cpp
+ * @brief Offline worst-case render cost of a map: DDA steps, overdraw and far rays
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Stands the camera on a grid of empty cells, renders every view angle the
+ * way renderGame does (same screen size, field of view, view distance and
+ * fog) without drawing anything, and records per frame:
+ *   steps      DDA steps summed over all screen columns
+ *   overdraw   pixels written (background fill, wall columns, fog pass)
+ *              per screen pixel
+ *   far rays   columns whose wall is in the fog, or past the view distance
+ * The worst angle of each position goes into a BMP heatmap (one pixel per
+ * sampled position, rows are x like the text map format) and a JSON report
+ * with totals and the most expensive spots.
+ *
+ * to compile: make map_analyzer
+ * usage: ./map_analyzer <map> [--step N] [--angles N] [--view-distance D]
+ *                             [--heatmap file.bmp] [--report file.json]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chunked_map.h"
+#include "map.h"
+#include "raycast.h"
+
+// Mirrors of the renderer's settings in main.cpp
+const int SCREEN_WIDTH = 800;
+const int SCREEN_HEIGHT = 600;
+const double CAMERA_PLANE = 0.66;
+const double DEFAULT_VIEW_DISTANCE = 64.0;
+const double FOG_START = 0.6;
+
+const int DEFAULT_ANGLES = 16;
+const int DEFAULT_SAMPLES_PER_SIDE = 128;   // Default --step keeps the grid about this size
+const int REPORT_WORST_SPOTS = 10;
+const uint8_t HEATMAP_WALL_GRAY = 40;
+
+// Worst frame seen from one sampled position
+struct SpotCost {
+    int x, y;              // Cell the camera stood in, -1 if the sample block has no empty cell
+    double angle;          // View angle of the most expensive frame, radians
+    uint64_t steps;        // DDA steps of that frame
+    uint64_t totalSteps;   // Summed over all angles, for the average
+    double overdraw;       // Worst over all angles
+    int farRays;           // Worst over all angles
+    int missedRays;        // Worst over all angles: nothing within the view distance
+};
+
+struct FrameCost {
+    uint64_t steps;
+    double overdraw;
+    int farRays;
+    int missedRays;
+};
+
+class MapAnalyzer {
+private:
+    ChunkedMap& map;
+    double viewDistance;
+    int angles;
+    int step;
+    int samplesX, samplesY;
+    std::vector<SpotCost> spots;
+
+    template<typename Map>
+    FrameCost renderFrame(Map& view, double posX, double posY, double angle) {
+        double dirX = std::cos(angle), dirY = std::sin(angle);
+        double planeX = dirY * CAMERA_PLANE, planeY = -dirX * CAMERA_PLANE;  // As the player turns in main.cpp
+        int horizon = SCREEN_HEIGHT / 2;
+
+        FrameCost cost = {0, 0, 0, 0};
+        uint64_t pixels = (uint64_t)SCREEN_WIDTH * SCREEN_HEIGHT;  // Sky and floor fill
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            double cameraX = 2 * x / double(SCREEN_WIDTH) - 1;
+            RayHit hit = castRay(view, posX, posY, dirX + planeX * cameraX, dirY + planeY * cameraX, viewDistance);
+            cost.steps += hit.steps;
+            if (hit.cell == 0) {
+                cost.missedRays++;
+                cost.farRays++;
+                continue;
+            }
+            int lineHeight = (int)(SCREEN_HEIGHT / hit.perpWallDist);
+            int drawStart = std::max(0, -lineHeight / 2 + horizon);
+            int drawEnd = std::min(SCREEN_HEIGHT - 1, lineHeight / 2 + horizon);
+            int wallPixels = std::max(0, drawEnd - drawStart);
+            pixels += wallPixels;
+            if (hit.perpWallDist > FOG_START * viewDistance) {
+                pixels += wallPixels;  // applyFog rewrites the column
+                cost.farRays++;
+            }
+        }
+        cost.overdraw = (double)pixels / ((double)SCREEN_WIDTH * SCREEN_HEIGHT);
+        return cost;
+    }
+
+    // The sample block's centre cell if it is empty, otherwise its first empty cell
+    bool findEmptyCell(int sampleX, int sampleY, int& cellX, int& cellY) const {
+        int firstX = sampleX * step, firstY = sampleY * step;
+        int lastX = std::min(firstX + step, map.width()), lastY = std::min(firstY + step, map.height());
+        int centreX = (firstX + lastX) / 2, centreY = (firstY + lastY) / 2;
+        ChunkedMap::Cursor cursor(map);
+        if (!cursor.solid(centreX, centreY)) {
+            cellX = centreX;
+            cellY = centreY;
+            return true;
+        }
+        for (int x = firstX; x < lastX; x++) {
+            for (int y = firstY; y < lastY; y++) {
+                if (!cursor.solid(x, y)) {
+                    cellX = x;
+                    cellY = y;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template<typename Map>
+    void analyzeRows(Map& view, int firstSampleX, int lastSampleX) {
+        for (int sx = firstSampleX; sx < lastSampleX; sx++) {
+            for (int sy = 0; sy < samplesY; sy++) {
+                SpotCost& spot = spots[(size_t)sx * samplesY + sy];
+                spot = SpotCost{-1, -1, 0, 0, 0, 0, 0, 0};
+                if (!findEmptyCell(sx, sy, spot.x, spot.y)) continue;
+
+                for (int a = 0; a < angles; a++) {
+                    double angle = 2 * M_PI * a / angles;
+                    FrameCost frame = renderFrame(view, spot.x + 0.5, spot.y + 0.5, angle);
+                    spot.totalSteps += frame.steps;
+                    if (frame.steps > spot.steps) {
+                        spot.steps = frame.steps;
+                        spot.angle = angle;
+                    }
+                    spot.overdraw = std::max(spot.overdraw, frame.overdraw);
+                    spot.farRays = std::max(spot.farRays, frame.farRays);
+                    spot.missedRays = std::max(spot.missedRays, frame.missedRays);
+                }
+            }
+        }
+    }
+
+    // Analyzes its rows through the view the map chose for the game's rays (leaping or not)
+    struct RowAnalyzer {
+        MapAnalyzer* analyzer;
+        int firstSampleX, lastSampleX;
+        template<typename Map>
+        void operator()(Map& view) const {
+            analyzer->analyzeRows(view, firstSampleX, lastSampleX);
+        }
+    };
+
+    // Blue (cheap) through green and yellow to red (the map's worst spot)
+    static void heatColor(double t, uint8_t& r, uint8_t& g, uint8_t& b) {
+        t = std::max(0.0, std::min(1.0, t));
+        const double stops[4][3] = {{0, 0, 255}, {0, 200, 0}, {255, 220, 0}, {255, 0, 0}};
+        double scaled = t * 3;
+        int i = std::min(2, (int)scaled);
+        double f = scaled - i;
+        r = (uint8_t)(stops[i][0] + (stops[i + 1][0] - stops[i][0]) * f);
+        g = (uint8_t)(stops[i][1] + (stops[i + 1][1] - stops[i][1]) * f);
+        b = (uint8_t)(stops[i][2] + (stops[i + 1][2] - stops[i][2]) * f);
+    }
+
+    static void writeLE(std::ofstream& file, uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            file.put((char)((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static std::string jsonString(const std::string& text) {
+        std::string quoted = "\"";
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '"' || text[i] == '\\') quoted += '\\';
+            quoted += text[i];
+        }
+        return quoted + "\"";
+    }
+
+public:
+    MapAnalyzer(ChunkedMap& chunkedMap, double distance, int angleCount, int sampleStep)
+        : map(chunkedMap), viewDistance(distance), angles(angleCount), step(sampleStep),
+          samplesX((chunkedMap.width() + sampleStep - 1) / sampleStep),
+          samplesY((chunkedMap.height() + sampleStep - 1) / sampleStep) {}
+
+    void run() {
+        spots.resize((size_t)samplesX * samplesY);
+        int threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount < 1) threadCount = 1;
+        if (threadCount > samplesX) threadCount = samplesX;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; t++) {
+            int firstX = (int)((uint64_t)samplesX * t / threadCount);
+            int lastX = (int)((uint64_t)samplesX * (t + 1) / threadCount);
+            threads.push_back(std::thread([this, firstX, lastX]() {
+                RowAnalyzer rows = {this, firstX, lastX};
+                map.withRayView(rows);
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+    }
+
+    uint64_t worstSteps() const {
+        uint64_t worst = 0;
+        for (size_t i = 0; i < spots.size(); i++) {
+            worst = std::max(worst, spots[i].steps);
+        }
+        return worst;
+    }
+
+    // 24-bit BMP, samplesY wide and samplesX tall; blocks without an empty cell are dark gray
+    bool writeHeatmap(const std::string& path) const {
+        uint64_t worst = std::max<uint64_t>(1, worstSteps());
+        int rowBytes = (samplesY * 3 + 3) & ~3;
+        uint32_t imageSize = (uint32_t)rowBytes * samplesX;
+
+        std::ofstream file(path.c_str(), std::ios::binary);
+        file.write("BM", 2);
+        writeLE(file, 54 + imageSize, 4);
+        writeLE(file, 0, 4);
+        writeLE(file, 54, 4);
+        writeLE(file, 40, 4);
+        writeLE(file, samplesY, 4);
+        writeLE(file, (uint32_t)-samplesX, 4);  // Negative height: rows top-down
+        writeLE(file, 1, 2);
+        writeLE(file, 24, 2);
+        writeLE(file, 0, 4);
+        writeLE(file, imageSize, 4);
+        writeLE(file, 2835, 4);
+        writeLE(file, 2835, 4);
+        writeLE(file, 0, 4);
+        writeLE(file, 0, 4);
+
+        std::vector<char> row(rowBytes, 0);
+        for (int sx = 0; sx < samplesX; sx++) {
+            for (int sy = 0; sy < samplesY; sy++) {
+                const SpotCost& spot = spots[(size_t)sx * samplesY + sy];
+                uint8_t r = HEATMAP_WALL_GRAY, g = HEATMAP_WALL_GRAY, b = HEATMAP_WALL_GRAY;
+                if (spot.x >= 0) heatColor((double)spot.steps / worst, r, g, b);
+                row[sy * 3] = (char)b;
+                row[sy * 3 + 1] = (char)g;
+                row[sy * 3 + 2] = (char)r;
+            }
+            file.write(row.data(), rowBytes);
+        }
+        return (bool)file;
+    }
+
+    bool writeReport(const std::string& path, const std::string& mapPath, const std::string& heatmapPath,
+                     double seconds) const {
+        std::vector<const SpotCost*> sampled;
+        double totalSteps = 0, totalOverdraw = 0, maxOverdraw = 0;
+        int maxFarRays = 0, maxMissedRays = 0;
+        for (size_t i = 0; i < spots.size(); i++) {
+            if (spots[i].x < 0) continue;
+            sampled.push_back(&spots[i]);
+            totalSteps += (double)spots[i].totalSteps / angles;
+            totalOverdraw += spots[i].overdraw;
+            maxOverdraw = std::max(maxOverdraw, spots[i].overdraw);
+            maxFarRays = std::max(maxFarRays, spots[i].farRays);
+            maxMissedRays = std::max(maxMissedRays, spots[i].missedRays);
+        }
+        size_t count = std::max<size_t>(1, sampled.size());
+        size_t worstCount = std::min<size_t>(REPORT_WORST_SPOTS, sampled.size());
+        std::partial_sort(sampled.begin(), sampled.begin() + worstCount, sampled.end(),
+                          [](const SpotCost* a, const SpotCost* b) { return a->steps > b->steps; });
+
+        std::ofstream file(path.c_str());
+        file << "{\n";
+        file << "  \"map\": " << jsonString(mapPath) << ",\n";
+        file << "  \"width\": " << map.width() << ",\n";
+        file << "  \"height\": " << map.height() << ",\n";
+        file << "  \"screen\": [" << SCREEN_WIDTH << ", " << SCREEN_HEIGHT << "],\n";
+        file << "  \"view_distance\": " << viewDistance << ",\n";
+        file << "  \"sample_step\": " << step << ",\n";
+        file << "  \"angles\": " << angles << ",\n";
+        file << "  \"positions\": " << sampled.size() << ",\n";
+        file << "  \"seconds\": " << seconds << ",\n";
+        file << "  \"heatmap\": " << jsonString(heatmapPath) << ",\n";
+        file << "  \"steps_per_frame\": {\"average\": " << totalSteps / count << ", \"worst\": " << worstSteps()
+             << "},\n";
+        file << "  \"overdraw\": {\"average_worst\": " << totalOverdraw / count << ", \"max\": " << maxOverdraw
+             << "},\n";
+        file << "  \"far_rays_per_frame\": {\"max\": " << maxFarRays << ", \"max_past_view_distance\": "
+             << maxMissedRays << "},\n";
+        file << "  \"worst_spots\": [";
+        for (size_t i = 0; i < worstCount; i++) {
+            const SpotCost& spot = *sampled[i];
+            file << (i ? "," : "") << "\n    {\"x\": " << spot.x << ", \"y\": " << spot.y
+                 << ", \"angle_degrees\": " << spot.angle * 180 / M_PI << ", \"steps\": " << spot.steps
+                 << ", \"overdraw\": " << spot.overdraw << ", \"far_rays\": " << spot.farRays << "}";
+        }
+        file << "\n  ]\n}\n";
+        return (bool)file;
+    }
+
+    void printSummary(double seconds) const {
+        size_t positions = 0;
+        const SpotCost* worst = nullptr;
+        for (size_t i = 0; i < spots.size(); i++) {
+            if (spots[i].x < 0) continue;
+            positions++;
+            if (!worst || spots[i].steps > worst->steps) worst = &spots[i];
+        }
+        std::cout << positions << " positions x " << angles << " angles in " << seconds << " s" << std::endl;
+        if (worst) {
+            std::cout << "Worst frame: " << worst->steps << " DDA steps at (" << worst->x << ", " << worst->y
+                      << ") facing " << worst->angle * 180 / M_PI << " degrees" << std::endl;
+        }
+    }
+};
+
+static void printUsage() {
+    std::cerr << "usage: map_analyzer <map> [--step N] [--angles N] [--view-distance D]" << std::endl;
+    std::cerr << "                          [--heatmap file.bmp] [--report file.json]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    std::string mapPath = argv[1];
+    std::string heatmapPath = "map_heatmap.bmp";
+    std::string reportPath = "map_report.json";
+    double viewDistance = DEFAULT_VIEW_DISTANCE;
+    int angles = DEFAULT_ANGLES;
+    int step = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--step" && i + 1 < argc) {
+            step = atoi(argv[++i]);
+        } else if (arg == "--angles" && i + 1 < argc) {
+            angles = atoi(argv[++i]);
+        } else if (arg == "--view-distance" && i + 1 < argc) {
+            viewDistance = atof(argv[++i]);
+        } else if (arg == "--heatmap" && i + 1 < argc) {
+            heatmapPath = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            reportPath = argv[++i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (angles < 1 || viewDistance <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    // Whole map resident: the analysis visits all of it, from several threads
+    GameMap source;
+    ChunkedMap world;
+    bool loaded;
+    if (hasExtension(mapPath, ".msc")) {
+        ChunkedMap chunked;
+        loaded = chunked.open(mapPath) && chunked.toGameMap(source, mapPath);
+    } else {
+        loaded = source.load(mapPath);
+    }
+    if (!loaded || !world.fromGameMap(source)) {
+        std::cerr << "Could not load " << mapPath << std::endl;
+        return 1;
+    }
+    if (step < 1) {
+        step = std::max(1, std::max(world.width(), world.height()) / DEFAULT_SAMPLES_PER_SIDE);
+    }
+
+    std::cout << "Analyzing " << mapPath << " (" << world.width() << "x" << world.height() << "), every " << step
+              << " cells, " << angles << " angles" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    MapAnalyzer analyzer(world, viewDistance, angles, step);
+    analyzer.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    analyzer.printSummary(seconds);
+
+    if (!analyzer.writeHeatmap(heatmapPath)) {
+        std::cerr << "Could not write " << heatmapPath << std::endl;
+        return 1;
+    }
+    if (!analyzer.writeReport(reportPath, mapPath, heatmapPath, seconds)) {
+        std::cerr << "Could not write " << reportPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << heatmapPath << " and " << reportPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file maptool.cpp
+ * @brief Converts and generates maps, prints map info, builds PVS caches and benchmarks the DDA
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The format is picked from the extension: .msc is chunked (chunked_map.h),
+ * .msm is binary, anything else is text (see map.h).
+ * to compile: make maptool
+ * usage: ./maptool convert <input> <output>
+ *        ./maptool info <map>
+ *        ./maptool generate <backtracker|wilson|rooms> <size> <seed> <output>
+ *        ./maptool pvs <map> [view distance]
+ *        ./maptool bench <size> [wall percent | maze type]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "chunked_map.h"
+#include "map.h"
+#include "maze_generator.h"
+#include "pvs.h"
+#include "raycast.h"
+
+const int BENCH_RAYS = 200000;
+const int BENCH_PASSES = 5;  // Timings are the fastest pass
+const int BENCH_DEFAULT_WALL_PERCENT = 5;
+const double PVS_DEFAULT_VIEW_DISTANCE = 64.0;  // Same as the game's default
+
+// The renderer's DDA before castRay(), with accumulated side distances
+static RayHit referenceRay(const GameMap& map, double posX, double posY, double rayDirX, double rayDirY) {
+    RayHit hit;
+    hit.mapX = int(posX);
+    hit.mapY = int(posY);
+    hit.side = 0;
+    double deltaDistX = std::abs(1 / rayDirX);
+    double deltaDistY = std::abs(1 / rayDirY);
+    int stepX = rayDirX < 0 ? -1 : 1;
+    int stepY = rayDirY < 0 ? -1 : 1;
+    double sideDistX = rayDirX < 0 ? (posX - hit.mapX) * deltaDistX : (hit.mapX + 1.0 - posX) * deltaDistX;
+    double sideDistY = rayDirY < 0 ? (posY - hit.mapY) * deltaDistY : (hit.mapY + 1.0 - posY) * deltaDistY;
+    do {
+        if (sideDistX < sideDistY) {
+            sideDistX += deltaDistX;
+            hit.mapX += stepX;
+            hit.side = 0;
+        } else {
+            sideDistY += deltaDistY;
+            hit.mapY += stepY;
+            hit.side = 1;
+        }
+    } while (map.cell(hit.mapX, hit.mapY) == 0);
+    return hit;
+}
+
+static void printUsage() {
+    std::cerr << "usage: maptool convert <input> <output>" << std::endl;
+    std::cerr << "       maptool info <map>" << std::endl;
+    std::cerr << "       maptool generate <backtracker|wilson|rooms> <size> <seed> <output>" << std::endl;
+    std::cerr << "       maptool pvs <map> [view distance]" << std::endl;
+    std::cerr << "       maptool bench <size> [wall percent | maze type]" << std::endl;
+}
+
+// Square map with enclosing walls and randomly scattered wall cells
+static bool generateScatter(GameMap& map, int size, int wallPercent, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> texture(1, 8);
+    std::vector<uint8_t> cells((size_t)size * size);
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+            cells[(size_t)x * size + y] = (border || percent(rng) < wallPercent) ? texture(rng) : 0;
+        }
+    }
+    int spawn = size / 2;
+    cells[(size_t)spawn * size + spawn] = 0;
+    return map.assign(size, size, std::move(cells), spawn + 0.5, spawn + 0.5, "generated map");
+}
+
+struct BenchRay {
+    double x, y;
+    double dirX, dirY;
+};
+
+// BENCH_RAYS rays from random empty cells in random directions
+static std::vector<BenchRay> makeBenchRays(const GameMap& map) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(1.0, map.width() - 1.0);
+    std::uniform_real_distribution<double> angle(0.0, 2 * M_PI);
+    std::vector<BenchRay> rays(BENCH_RAYS);
+    for (size_t i = 0; i < rays.size(); i++) {
+        do {
+            rays[i].x = coord(rng);
+            rays[i].y = coord(rng);
+        } while (map.cell((int)rays[i].x, (int)rays[i].y) != 0);
+        double a = angle(rng);
+        rays[i].dirX = std::cos(a);
+        rays[i].dirY = std::sin(a);
+    }
+    return rays;
+}
+
+/**
+ * Cast every ray and report DDA steps (average and worst case), speed, and
+ * how many hits differ from the reference DDA. Speed is the fastest of
+ * BENCH_PASSES passes, in rays/s and relative to baselineRaysPerSecond
+ * (0 for none). Returns rays/s.
+ */
+template<typename Map>
+static double benchRays(const char* name, Map& map, const GameMap& source, const std::vector<BenchRay>& rays,
+                        double baselineRaysPerSecond) {
+    uint64_t steps = 0;
+    int worst = 0;
+    double seconds = 0;
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        steps = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); i++) {
+            RayHit hit = castRay(map, rays[i].x, rays[i].y, rays[i].dirX, rays[i].dirY);
+            steps += hit.steps;
+            if (hit.steps > worst) worst = hit.steps;
+        }
+        double passSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (pass == 0 || passSeconds < seconds) seconds = passSeconds;
+    }
+
+    int mismatches = 0;
+    for (size_t i = 0; i < rays.size(); i++) {
+        RayHit hit = castRay(map, rays[i].x, rays[i].y, rays[i].dirX, rays[i].dirY);
+        RayHit reference = referenceRay(source, rays[i].x, rays[i].y, rays[i].dirX, rays[i].dirY);
+        if (hit.mapX != reference.mapX || hit.mapY != reference.mapY || hit.side != reference.side) mismatches++;
+    }
+
+    double raysPerSecond = rays.size() / seconds;
+    std::cout << "  " << name << ": " << (double)steps / rays.size() << " steps/ray (worst " << worst << "), "
+              << steps / seconds / 1e6 << " M steps/s, " << raysPerSecond / 1e6 << " M rays/s";
+    if (baselineRaysPerSecond > 0) {
+        std::cout << " (" << raysPerSecond / baselineRaysPerSecond << "x)";
+    }
+    std::cout << ", " << mismatches << " mismatched hits" << std::endl;
+    return raysPerSecond;
+}
+
+static bool loadMap(GameMap& map, const std::string& path) {
+    bool loaded;
+    if (hasExtension(path, ".msc")) {
+        ChunkedMap chunked;
+        loaded = chunked.open(path) && chunked.toGameMap(map, path);
+    } else {
+        loaded = map.load(path);
+    }
+    if (!loaded) {
+        std::cerr << "Could not load " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+    std::string command = argv[1];
+    GameMap map;
+
+    if (command == "convert" && argc == 4) {
+        if (!loadMap(map, argv[2])) return 1;
+        std::string output = argv[3];
+        bool saved = hasExtension(output, ".msc") ? ChunkedMap::write(map, output) : map.save(output);
+        if (!saved) {
+            std::cerr << "Could not write " << argv[3] << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << argv[3] << " (" << map.width() << "x" << map.height() << ")" << std::endl;
+        return 0;
+    }
+
+    if (command == "info" && argc == 3) {
+        if (!loadMap(map, argv[2])) return 1;
+
+        int walls = 0;
+        for (int x = 0; x < map.width(); x++) {
+            for (int y = 0; y < map.height(); y++) {
+                if (map.cell(x, y) != 0) walls++;
+            }
+        }
+        std::cout << argv[2] << ": " << map.width() << "x" << map.height() << " cells, "
+                  << walls << " walls, spawn at (" << map.spawnX() << ", " << map.spawnY() << ")" << std::endl;
+        return 0;
+    }
+
+    if (command == "generate" && argc == 6) {
+        MazeAlgorithm algorithm;
+        if (!parseMazeAlgorithm(argv[2], algorithm)) {
+            std::cerr << "Unknown maze type: " << argv[2] << std::endl;
+            return 1;
+        }
+        int size = atoi(argv[3]);
+        auto start = std::chrono::steady_clock::now();
+        MazeGenerator generator(size, size, strtoull(argv[4], nullptr, 10));
+        if (size < 0 || !generator.generate(algorithm, map)) {
+            std::cerr << "Size must be " << MAZE_MIN_SIZE << " to " << MAZE_MAX_SIZE << std::endl;
+            return 1;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::string output = argv[5];
+        bool saved = hasExtension(output, ".msc") ? ChunkedMap::write(map, output) : map.save(output);
+        if (!saved) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+        std::cout << "Generated " << size << "x" << size << " " << mazeAlgorithmName(algorithm) << " maze in "
+                  << ms << " ms, wrote " << output << std::endl;
+        return 0;
+    }
+
+    if (command == "pvs" && (argc == 3 || argc == 4)) {
+        if (!loadMap(map, argv[2])) return 1;
+        double viewDistance = argc == 4 ? atof(argv[3]) : PVS_DEFAULT_VIEW_DISTANCE;
+        VisibilitySet pvs;
+        if (!pvs.build(map, map.width(), map.height(), viewDistance)) {
+            std::cerr << "Map is too big for a PVS" << std::endl;
+            return 1;
+        }
+        pvs.printStats();
+        std::string output = std::string(argv[2]) + ".pvs";
+        if (!pvs.save(output)) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << output << std::endl;
+        return 0;
+    }
+
+    if (command == "bench" && (argc == 3 || argc == 4)) {
+        int size = atoi(argv[2]);
+        int wallPercent = argc == 4 ? atoi(argv[3]) : BENCH_DEFAULT_WALL_PERCENT;
+        MazeAlgorithm algorithm;
+        bool maze = argc == 4 && parseMazeAlgorithm(argv[3], algorithm);
+        bool generated;
+        if (maze) {
+            MazeGenerator generator(size, size, 1);
+            generated = size > 0 && generator.generate(algorithm, map);
+        } else {
+            generated = size >= 3 && (uint32_t)size <= CHUNKED_MAP_MAX_SIZE && generateScatter(map, size, wallPercent, 1);
+        }
+        if (!generated) {
+            std::cerr << "Invalid size" << std::endl;
+            return 1;
+        }
+        ChunkedMap chunked;
+        chunked.fromGameMap(map);
+        ChunkedMapView<false, false> byteMap = {chunked};
+        ChunkedMapView<true, false> bitMap = {chunked};
+        ChunkedMapView<true, true> skipMap = {chunked};
+        std::vector<BenchRay> rays = makeBenchRays(map);
+        std::cout << size << "x" << size << " ";
+        if (maze) {
+            std::cout << mazeAlgorithmName(algorithm) << " maze, ";
+        } else {
+            std::cout << "map, " << wallPercent << "% walls, ";
+        }
+        std::cout << BENCH_RAYS << " rays" << std::endl;
+        double baseline = benchRays("cell bytes", byteMap, map, rays, 0);
+        benchRays("occupancy bits", bitMap, map, rays, baseline);
+        benchRays("empty-space skipping", skipMap, map, rays, baseline);
+        std::cout << "  the game's rays test the " << (chunked.bitmapTest() ? "occupancy bits" : "cell bytes")
+                  << " and " << (chunked.leaping() ? "skip empty space" : "walk cell by cell") << " in this map"
+                  << std::endl;
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,432 @@
+/**
+ * @file maze_generator.h
+ * @brief Seeded procedural mazes for gameplay and benchmarks
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Three layouts, all reproducible from (algorithm, width, height, seed) on
+ * any platform, since the generator brings its own PRNG (SplitMix64)
+ * instead of relying on <random> distributions:
+ *
+ *   backtracker   perfect maze from a depth-first carve, long winding
+ *                 corridors
+ *   wilson        perfect maze from loop-erased random walks, an unbiased
+ *                 spanning tree with many short dead ends
+ *   rooms         rectangular rooms joined by L-shaped corridors
+ *
+ * Maze corridors are one cell wide on odd coordinates, so the usable area
+ * is (width - 1) / 2 by (height - 1) / 2 junctions. Walls get a texture
+ * per 16x16 zone; room walls take their room's texture. The border is
+ * always solid, so the result passes GameMap validation.
+ *
+ * No SDL dependency, so the command-line tools can use it too.
+ */
+
+#ifndef MAZE_GENERATOR_H
+#define MAZE_GENERATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "map.h"
+
+const uint32_t MAZE_MIN_SIZE = 5;
+const uint32_t MAZE_MAX_SIZE = 8192;
+const int MAZE_WALL_TEXTURES = 7;           // Texture ids 1..7
+const int MAZE_TEXTURE_ZONE_SHIFT = 4;      // 16x16 cells share a wall texture
+const int ROOM_MIN_SIZE = 3;
+const int ROOM_MAX_SIZE = 11;
+const int ROOM_CELLS_PER_ATTEMPT = 150;     // Map area per room placement attempt
+const int ROOM_MIN_ATTEMPTS = 32;
+const int ROOM_EXTRA_LINK_PERCENT = 15;     // Rooms also joined to their second predecessor
+
+const uint8_t JUNCTION_VISITED = 0x01;
+const uint8_t JUNCTION_OPEN_X = 0x02;       // Passage to (jx + 1, jy)
+const uint8_t JUNCTION_OPEN_Y = 0x04;       // Passage to (jx, jy + 1)
+const int JUNCTION_DIR_SHIFT = 3;           // Two bits: parent (backtracker) or exit (Wilson) direction
+const uint8_t JUNCTION_BORDER = 0x20;       // Ring around the grid; counts as visited, never walked onto
+
+// Directions +x, -x, +y, -y; dir ^ 1 is the opposite direction
+const int MAZE_DX[4] = {1, -1, 0, 0};
+const int MAZE_DY[4] = {0, 0, 1, -1};
+
+// For a 4-bit set of directions: how many there are, and the nth of them in increasing order
+const int MAZE_OPEN_COUNT[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+const int8_t MAZE_OPEN_DIRECTIONS[16][4] = {
+    {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 1, 0, 0},
+    {2, 0, 0, 0}, {0, 2, 0, 0}, {1, 2, 0, 0}, {0, 1, 2, 0},
+    {3, 0, 0, 0}, {0, 3, 0, 0}, {1, 3, 0, 0}, {0, 1, 3, 0},
+    {2, 3, 0, 0}, {0, 2, 3, 0}, {1, 2, 3, 0}, {0, 1, 2, 3}
+};
+
+enum MazeAlgorithm {
+    MAZE_BACKTRACKER,
+    MAZE_WILSON,
+    MAZE_ROOMS
+};
+
+inline const char* mazeAlgorithmName(MazeAlgorithm algorithm) {
+    switch (algorithm) {
+        case MAZE_WILSON: return "wilson";
+        case MAZE_ROOMS: return "rooms";
+        default: return "backtracker";
+    }
+}
+
+inline bool parseMazeAlgorithm(const std::string& name, MazeAlgorithm& algorithm) {
+    if (name == "backtracker") algorithm = MAZE_BACKTRACKER;
+    else if (name == "wilson") algorithm = MAZE_WILSON;
+    else if (name == "rooms") algorithm = MAZE_ROOMS;
+    else return false;
+    return true;
+}
+
+// SplitMix64: small, fast and identical everywhere
+class MazeRandom {
+private:
+    uint64_t state;
+    uint64_t directionBits;   // Unused 2-bit draws from the last next()
+    int directionsLeft;
+
+public:
+    explicit MazeRandom(uint64_t seed) : state(seed), directionBits(0), directionsLeft(0) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n) for n up to 2^32
+    uint32_t below(uint32_t n) {
+        return (uint32_t)(((next() >> 32) * n) >> 32);
+    }
+
+    // Uniform in [0, n) for n up to 4, 2 bits at a time (the walks' hot path)
+    int direction(int n) {
+        for (;;) {
+            if (directionsLeft == 0) {
+                directionBits = next();
+                directionsLeft = 32;
+            }
+            int value = (int)(directionBits & 3);
+            directionBits >>= 2;
+            directionsLeft--;
+            if (value < n) return value;
+        }
+    }
+};
+
+class MazeGenerator {
+private:
+    struct Room {
+        int x, y;          // First interior cell
+        int width, height;
+        uint8_t texture;
+        uint64_t order;    // Morton code of the centre, so neighbours link up
+    };
+
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    uint64_t seed;
+    MazeRandom rng;
+    std::vector<uint8_t> cells;   // Column-major; 0 empty, anything else wall
+    std::vector<Room> rooms;
+    double spawnX, spawnY;
+
+    // Junctions of the corridor grid: (jx, jy) is cell (2 jx + 1, 2 jy + 1)
+    int junctionsX() const { return (int)(mapWidth - 1) / 2; }
+    int junctionsY() const { return (int)(mapHeight - 1) / 2; }
+
+    /**
+     * The maze algorithms work on one byte per junction in a flat,
+     * column-major array with a one-junction JUNCTION_BORDER ring, so a
+     * walk moves by adding neighbourOffset[dir] and needs no bounds
+     * checks. emitCells() turns the result into cells in one sequential
+     * pass.
+     */
+    std::vector<uint8_t> junctions;
+    ptrdiff_t junctionStride;         // Column length including the border
+    ptrdiff_t neighbourOffset[4];     // Index step in each direction
+    ptrdiff_t passageOffset[4];       // Junction holding the passage bit towards dir, relative to the walker
+    uint8_t passageBit[4];
+
+    size_t junctionIndex(int jx, int jy) const {
+        return (size_t)(jx + 1) * junctionStride + (jy + 1);
+    }
+
+    void resetJunctions() {
+        int countX = junctionsX(), countY = junctionsY();
+        junctionStride = countY + 2;
+        junctions.assign((size_t)(countX + 2) * junctionStride, 0);
+        for (int jx = -1; jx <= countX; jx++) {
+            junctions[junctionIndex(jx, -1)] = junctions[junctionIndex(jx, countY)] = JUNCTION_BORDER | JUNCTION_VISITED;
+        }
+        for (int jy = 0; jy < countY; jy++) {
+            junctions[junctionIndex(-1, jy)] = junctions[junctionIndex(countX, jy)] = JUNCTION_BORDER | JUNCTION_VISITED;
+        }
+        for (int dir = 0; dir < 4; dir++) {
+            neighbourOffset[dir] = MAZE_DX[dir] * junctionStride + MAZE_DY[dir];
+            passageOffset[dir] = dir == 1 ? -junctionStride : (dir == 3 ? -1 : 0);
+            passageBit[dir] = dir < 2 ? JUNCTION_OPEN_X : JUNCTION_OPEN_Y;
+        }
+    }
+
+    // Open the wall between the junction at index and its neighbour in direction dir
+    void openPassage(size_t index, int dir) {
+        junctions[index + passageOffset[dir]] |= passageBit[dir];
+    }
+
+    static int storedDirection(uint8_t value) {
+        return (value >> JUNCTION_DIR_SHIFT) & 3;
+    }
+
+    static uint8_t withDirection(uint8_t value, int dir) {
+        return (uint8_t)((value & ~(3 << JUNCTION_DIR_SHIFT)) | (dir << JUNCTION_DIR_SHIFT));
+    }
+
+    // Depth-first carve; each junction remembers the way back to its parent instead of using a stack
+    void carveBacktracker() {
+        uint8_t* grid = junctions.data();
+        size_t root = junctionIndex(0, 0);
+        size_t index = root;
+        grid[root] = JUNCTION_VISITED;
+
+        for (;;) {
+            // Bit dir set for each unvisited neighbour, built without branches
+            int open = 0;
+            for (int dir = 0; dir < 4; dir++) {
+                open |= (~grid[index + neighbourOffset[dir]] & JUNCTION_VISITED) << dir;
+            }
+            if (open == 0) {
+                if (index == root) break;
+                index += neighbourOffset[storedDirection(grid[index])];
+                continue;
+            }
+            int dir = MAZE_OPEN_DIRECTIONS[open][rng.direction(MAZE_OPEN_COUNT[open])];
+            openPassage(index, dir);
+            index += neighbourOffset[dir];
+            grid[index] = withDirection(grid[index] | JUNCTION_VISITED, dir ^ 1);
+        }
+        spawnX = spawnY = 1.5;
+    }
+
+    /**
+     * Wilson's algorithm. Its cost is the random walks' total length,
+     * which is about the time a walk takes to find the root and does not
+     * depend on the order walks start in: 110 to 400 million steps at
+     * 8191x8191 depending on the seed, against 33 million for the
+     * backtracker.
+     */
+    void carveWilson() {
+        uint8_t* grid = junctions.data();
+        int rootX = (int)rng.below(junctionsX()), rootY = (int)rng.below(junctionsY());
+        grid[junctionIndex(rootX, rootY)] = JUNCTION_VISITED;
+
+        // Start walks in storage order, so consecutive walks begin next to each other; the border is visited
+        for (size_t start = 0; start < junctions.size(); start++) {
+            if (grid[start] & JUNCTION_VISITED) continue;
+
+            // Random walk until the tree is hit; revisits overwrite the exit direction, erasing loops
+            size_t index = start;
+            while (!(grid[index] & JUNCTION_VISITED)) {
+                int dir;
+                do {
+                    dir = rng.direction(4);
+                } while (grid[index + neighbourOffset[dir]] & JUNCTION_BORDER);
+                grid[index] = withDirection(grid[index], dir);
+                index += neighbourOffset[dir];
+            }
+
+            // Add the loop-erased path to the tree
+            index = start;
+            while (!(grid[index] & JUNCTION_VISITED)) {
+                grid[index] |= JUNCTION_VISITED;
+                int dir = storedDirection(grid[index]);
+                openPassage(index, dir);
+                index += neighbourOffset[dir];
+            }
+        }
+        spawnX = spawnY = 1.5;
+    }
+
+    void emitCells() {
+        int countX = junctionsX(), countY = junctionsY();
+        for (int jx = 0; jx < countX; jx++) {
+            uint8_t* column = &cells[(size_t)(2 * jx + 1) * mapHeight];
+            uint8_t* nextColumn = column + mapHeight;
+            const uint8_t* junctionColumn = &junctions[junctionIndex(jx, 0)];
+            // Every wall slot between junctions has exactly one owner, so write it either way (no branches)
+            for (int jy = 0; jy < countY; jy++) {
+                uint8_t value = junctionColumn[jy];
+                column[2 * jy + 1] = 0;
+                column[2 * jy + 2] = (value & JUNCTION_OPEN_Y) ? 0 : 1;
+                nextColumn[2 * jy + 1] = (value & JUNCTION_OPEN_X) ? 0 : 1;
+            }
+        }
+        junctions.clear();
+        junctions.shrink_to_fit();
+    }
+
+    uint8_t& at(int x, int y) {
+        return cells[(size_t)x * mapHeight + y];
+    }
+
+    static uint64_t mortonCode(uint32_t x, uint32_t y) {
+        uint64_t code = 0;
+        for (int bit = 0; bit < 16; bit++) {
+            code |= (uint64_t)((x >> bit) & 1) << (2 * bit);
+            code |= (uint64_t)((y >> bit) & 1) << (2 * bit + 1);
+        }
+        return code;
+    }
+
+    // Axis-aligned run of empty cells, ends included
+    void carveLine(int x0, int y0, int x1, int y1) {
+        for (int x = std::min(x0, x1); x <= std::max(x0, x1); x++) {
+            for (int y = std::min(y0, y1); y <= std::max(y0, y1); y++) {
+                at(x, y) = 0;
+            }
+        }
+    }
+
+    // L-shaped corridor, horizontal or vertical leg first at random
+    void carveCorridor(int fromX, int fromY, int toX, int toY) {
+        bool xFirst = rng.below(2) == 0;
+        int cornerX = xFirst ? toX : fromX;
+        int cornerY = xFirst ? fromY : toY;
+        carveLine(fromX, fromY, cornerX, cornerY);
+        carveLine(cornerX, cornerY, toX, toY);
+    }
+
+    void carveRooms() {
+        // Small maps get more tries and rooms scaled to the map, so they still have several
+        int attempts = std::max(ROOM_MIN_ATTEMPTS, (int)((uint64_t)mapWidth * mapHeight / ROOM_CELLS_PER_ATTEMPT));
+        int maxWidth = std::max(ROOM_MIN_SIZE, std::min(ROOM_MAX_SIZE, (int)mapWidth / 3));
+        int maxHeight = std::max(ROOM_MIN_SIZE, std::min(ROOM_MAX_SIZE, (int)mapHeight / 3));
+
+        for (int i = 0; i < attempts; i++) {
+            Room room;
+            room.width = ROOM_MIN_SIZE + rng.below(std::max(1, maxWidth - ROOM_MIN_SIZE + 1));
+            room.height = ROOM_MIN_SIZE + rng.below(std::max(1, maxHeight - ROOM_MIN_SIZE + 1));
+            room.x = 1 + rng.below(mapWidth - room.width - 1);
+            room.y = 1 + rng.below(mapHeight - room.height - 1);
+
+            // Keep a wall between rooms: the area plus a one-cell margin must still be solid
+            bool free = true;
+            for (int x = room.x - 1; x <= room.x + room.width && free; x++) {
+                for (int y = room.y - 1; y <= room.y + room.height; y++) {
+                    if (at(x, y) == 0) {
+                        free = false;
+                        break;
+                    }
+                }
+            }
+            if (!free) continue;
+
+            for (int x = room.x; x < room.x + room.width; x++) {
+                for (int y = room.y; y < room.y + room.height; y++) {
+                    at(x, y) = 0;
+                }
+            }
+            room.texture = (uint8_t)(1 + rng.below(MAZE_WALL_TEXTURES));
+            room.order = mortonCode(room.x + room.width / 2, room.y + room.height / 2);
+            rooms.push_back(room);
+        }
+        if (rooms.empty()) {
+            // Too small for any room: a single open area
+            Room room = {1, 1, (int)mapWidth - 2, (int)mapHeight - 2, 1, 0};
+            for (int x = 1; x < (int)mapWidth - 1; x++) {
+                for (int y = 1; y < (int)mapHeight - 1; y++) at(x, y) = 0;
+            }
+            rooms.push_back(room);
+        }
+
+        // Join rooms along a Morton curve, so corridors stay short
+        std::sort(rooms.begin(), rooms.end(), [](const Room& a, const Room& b) { return a.order < b.order; });
+        for (size_t i = 1; i < rooms.size(); i++) {
+            const Room& a = rooms[i - 1];
+            const Room& b = rooms[i];
+            carveCorridor(a.x + a.width / 2, a.y + a.height / 2, b.x + b.width / 2, b.y + b.height / 2);
+            if (i >= 2 && (int)rng.below(100) < ROOM_EXTRA_LINK_PERCENT) {
+                const Room& c = rooms[i - 2];
+                carveCorridor(c.x + c.width / 2, c.y + c.height / 2, b.x + b.width / 2, b.y + b.height / 2);
+            }
+        }
+        spawnX = rooms[0].x + rooms[0].width / 2 + 0.5;
+        spawnY = rooms[0].y + rooms[0].height / 2 + 0.5;
+    }
+
+    void assignTextures() {
+        int zonesX = (mapWidth >> MAZE_TEXTURE_ZONE_SHIFT) + 1;
+        int zonesY = (mapHeight >> MAZE_TEXTURE_ZONE_SHIFT) + 1;
+        std::vector<uint8_t> zoneTextures((size_t)zonesX * zonesY);
+        MazeRandom zoneRng(seed ^ 0x5A5A5A5A5A5A5A5AULL);
+        for (size_t i = 0; i < zoneTextures.size(); i++) {
+            zoneTextures[i] = (uint8_t)(1 + zoneRng.below(MAZE_WALL_TEXTURES));
+        }
+
+        // Walls are still 1 here, so multiplying by the zone's texture leaves empty cells at 0
+        int zoneSize = 1 << MAZE_TEXTURE_ZONE_SHIFT;
+        for (int x = 0; x < (int)mapWidth; x++) {
+            const uint8_t* zoneColumn = &zoneTextures[(size_t)(x >> MAZE_TEXTURE_ZONE_SHIFT) * zonesY];
+            uint8_t* column = &cells[(size_t)x * mapHeight];
+            for (int zoneStart = 0; zoneStart < (int)mapHeight; zoneStart += zoneSize) {
+                uint8_t texture = zoneColumn[zoneStart >> MAZE_TEXTURE_ZONE_SHIFT];
+                int zoneEnd = std::min(zoneStart + zoneSize, (int)mapHeight);
+                for (int y = zoneStart; y < zoneEnd; y++) {
+                    column[y] *= texture;
+                }
+            }
+        }
+        for (size_t i = 0; i < rooms.size(); i++) {
+            const Room& room = rooms[i];
+            for (int x = room.x - 1; x <= room.x + room.width; x++) {
+                for (int y = room.y - 1; y <= room.y + room.height; y++) {
+                    if (at(x, y) != 0) at(x, y) = room.texture;
+                }
+            }
+        }
+    }
+
+public:
+    MazeGenerator(uint32_t width, uint32_t height, uint64_t mazeSeed)
+        : mapWidth(width), mapHeight(height), seed(mazeSeed), rng(mazeSeed), spawnX(1.5), spawnY(1.5), junctionStride(0) {}
+
+    /**
+     * Generate into map. Returns false (map untouched) if the size is
+     * outside MAZE_MIN_SIZE..MAZE_MAX_SIZE.
+     */
+    bool generate(MazeAlgorithm algorithm, GameMap& map) {
+        if (mapWidth < MAZE_MIN_SIZE || mapHeight < MAZE_MIN_SIZE ||
+            mapWidth > MAZE_MAX_SIZE || mapHeight > MAZE_MAX_SIZE) {
+            return false;
+        }
+        rng = MazeRandom(seed);
+        rooms.clear();
+        cells.assign((size_t)mapWidth * mapHeight, 1);
+
+        if (algorithm == MAZE_ROOMS) {
+            carveRooms();
+        } else {
+            resetJunctions();
+            if (algorithm == MAZE_WILSON) {
+                carveWilson();
+            } else {
+                carveBacktracker();
+            }
+            emitCells();
+        }
+        assignTextures();
+
+        std::string name = std::string("generated ") + mazeAlgorithmName(algorithm) + " maze";
+        return map.assign(mapWidth, mapHeight, std::move(cells), spawnX, spawnY, name);
+    }
+};
+
+#endif // MAZE_GENERATOR_H
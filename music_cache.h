@@ -0,0 +1,348 @@
+/**
+ * @file music_cache.h
+ * @brief Music tracks played from pre-decoded PCM instead of streamed MP3
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Mix_LoadMUS keeps decoding the MP3 on the audio thread for as long as the
+ * track plays. With a music cache the whole track is decoded once, on a
+ * background thread, to the device's sample format and played from memory
+ * on a reserved mixer channel:
+ *
+ *   off     stream the MP3 (least memory, MP3 decode CPU on the audio thread)
+ *   memory  decode at startup into a heap buffer (~10 MB per minute of
+ *           44.1 kHz stereo S16, no decode while playing)
+ *   disk    like memory, but the PCM is written next to the MP3
+ *           (music/<track>.mp3.pcm) and memory-mapped; later runs skip
+ *           decoding entirely and the pages live in the shared page cache
+ *
+ * The streamed track is used until decoding finishes, and whenever it fails
+ * (decoding MP3 into a chunk needs SDL_mixer 2.6 or newer). update(),
+ * called every tick for the playing track, crossfades it from the stream
+ * to the PCM as soon as decoding is done.
+ */
+
+#ifndef MUSIC_CACHE_H
+#define MUSIC_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum MusicCacheMode {
+    MUSIC_CACHE_OFF,
+    MUSIC_CACHE_MEMORY,
+    MUSIC_CACHE_DISK
+};
+
+const char PCM_CACHE_MAGIC[4] = {'M', 'P', 'C', 'M'};
+const Uint32 PCM_CACHE_VERSION = 1;
+const char* const PCM_CACHE_SUFFIX = ".pcm";
+const int MUSIC_SWITCH_FADE_MS = 500;  // Stream to PCM crossfade once decoding finishes
+
+// Cached PCM follows this header; it is only valid for the same device
+// format and an unchanged source file
+struct PcmCacheHeader {
+    char magic[4];
+    Uint32 version;
+    Uint32 frequency;
+    Uint16 format;
+    Uint16 channels;
+    Uint64 sourceSize;
+    Uint64 sourceMtime;
+    Uint64 dataSize;
+    Uint8 padding[64 - 40];
+};
+
+static_assert(sizeof(PcmCacheHeader) == 64, "PcmCacheHeader layout");
+
+class CachedMusic {
+private:
+    std::string path;
+    std::string name;
+    MusicCacheMode mode;
+    Mix_Music* stream;
+    Mix_Chunk* pcm;
+
+    // Last play() call, for moving a streaming track over to its PCM
+    bool streaming;
+    int playChannel;
+    int playVolume;
+
+    // Background decode; decodedChunk (or decodeError) is handed over once decoded is set
+    std::thread decoder;
+    std::atomic<bool> decoded;
+    Mix_Chunk* decodedChunk;
+    std::string decodeError;  // SDL errors are per thread, so the decoder saves its own
+    double decodeMs;
+
+    // Mapped cache file (disk mode)
+    void* mapping;
+    size_t mappingSize;
+
+    int deviceFrequency;
+    Uint16 deviceFormat;
+    int deviceChannels;
+
+    bool fillHeader(PcmCacheHeader& header, Uint64 dataSize) const {
+#ifndef _WIN32
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, PCM_CACHE_MAGIC, sizeof(header.magic));
+        header.version = PCM_CACHE_VERSION;
+        header.frequency = deviceFrequency;
+        header.format = deviceFormat;
+        header.channels = deviceChannels;
+        header.sourceSize = st.st_size;
+        header.sourceMtime = st.st_mtime;
+        header.dataSize = dataSize;
+        return true;
+#else
+        (void)header;
+        (void)dataSize;
+        return false;
+#endif
+    }
+
+    // Decoder thread: same temp-file-and-rename scheme as the asset packer
+    void writeCache(const Uint8* samples, Uint32 bytes) const {
+        PcmCacheHeader header;
+        if (!fillHeader(header, bytes)) return;
+
+        std::string cachePath = path + PCM_CACHE_SUFFIX;
+        std::string tempPath = cachePath + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Could not write music cache " << cachePath << std::endl;
+            return;
+        }
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(samples, 1, bytes, file) == bytes;
+        ok = fclose(file) == 0 && ok;
+        if (!ok || std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+            std::cerr << "Could not write music cache " << cachePath << std::endl;
+            std::remove(tempPath.c_str());
+        }
+    }
+
+    bool mapCache() {
+#ifndef _WIN32
+        std::string cachePath = path + PCM_CACHE_SUFFIX;
+        int fd = ::open(cachePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PcmCacheHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        const PcmCacheHeader* cached = (const PcmCacheHeader*)mapped;
+        PcmCacheHeader expected;
+        if (!fillHeader(expected, cached->dataSize) ||
+            memcmp(cached, &expected, sizeof(expected)) != 0 ||
+            sizeof(PcmCacheHeader) + cached->dataSize > (Uint64)st.st_size) {
+            std::cout << "Music cache " << cachePath << " is stale, decoding again" << std::endl;
+            munmap(mapped, st.st_size);
+            return false;
+        }
+
+        // SDL_mixer only reads from the chunk, the mapping stays read-only
+        pcm = Mix_QuickLoad_RAW((Uint8*)mapped + sizeof(PcmCacheHeader), (Uint32)cached->dataSize);
+        if (!pcm) {
+            munmap(mapped, st.st_size);
+            return false;
+        }
+        mapping = mapped;
+        mappingSize = st.st_size;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void decode() {
+        Uint64 start = SDL_GetPerformanceCounter();
+        Mix_Chunk* chunk = Mix_LoadWAV(path.c_str());
+        decodeMs = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+        if (!chunk) {
+            decodeError = Mix_GetError();
+        } else if (mode == MUSIC_CACHE_DISK) {
+            writeCache(chunk->abuf, chunk->alen);
+        }
+        decodedChunk = chunk;
+        decoded.store(true, std::memory_order_release);
+    }
+
+    // Take over the decoder's result once it is done
+    void poll() {
+        if (!decoder.joinable() || !decoded.load(std::memory_order_acquire)) return;
+        decoder.join();
+
+        if (!decodedChunk) {
+            std::cout << "Could not decode " << name << " (" << decodeError << "), streaming it instead" << std::endl;
+            return;
+        }
+        std::cout << "Decoded " << name << " in " << decodeMs << " ms: "
+                  << decodedChunk->alen / (1024.0 * 1024.0) << " MB PCM" << std::endl;
+
+        if (mode == MUSIC_CACHE_DISK && mapCache()) {
+            // Play from the page cache and drop the private copy
+            Mix_FreeChunk(decodedChunk);
+        } else {
+            pcm = decodedChunk;
+        }
+        decodedChunk = nullptr;
+    }
+
+public:
+    CachedMusic() : mode(MUSIC_CACHE_OFF), stream(nullptr), pcm(nullptr), streaming(false), playChannel(0),
+                    playVolume(0), decoded(false),
+                    decodedChunk(nullptr), decodeMs(0), mapping(nullptr), mappingSize(0),
+                    deviceFrequency(0), deviceFormat(0), deviceChannels(0) {}
+
+    ~CachedMusic() {
+        free();
+    }
+
+    /**
+     * Open the track for streaming and, unless mode is MUSIC_CACHE_OFF, get
+     * its PCM from the disk cache or start decoding it in the background.
+     * The audio device must already be open.
+     */
+    bool load(const std::string& trackPath, MusicCacheMode cacheMode) {
+        free();
+        path = trackPath;
+        name = trackPath.substr(trackPath.find_last_of('/') + 1);
+        mode = cacheMode;
+#ifdef _WIN32
+        if (mode == MUSIC_CACHE_DISK) {
+            mode = MUSIC_CACHE_MEMORY;
+        }
+#endif
+
+        stream = Mix_LoadMUS(path.c_str());
+        if (!stream) {
+            std::cout << "Could not load " << path << ": " << Mix_GetError() << std::endl;
+            return false;
+        }
+        if (mode == MUSIC_CACHE_OFF) {
+            return true;
+        }
+
+        Mix_QuerySpec(&deviceFrequency, &deviceFormat, &deviceChannels);
+        if (mode == MUSIC_CACHE_DISK && mapCache()) {
+            std::cout << "Mapped cached PCM for " << name << ": "
+                      << mappingSize / (1024.0 * 1024.0) << " MB" << std::endl;
+            return true;
+        }
+
+        decoded.store(false);
+        decodeError.clear();
+        decoder = std::thread(&CachedMusic::decode, this);
+        return true;
+    }
+
+    bool isLoaded() const {
+        return stream != nullptr;
+    }
+
+    /**
+     * Loop the track: from PCM on the given (reserved) channel when it is
+     * ready, otherwise streamed. Stops whatever music was playing.
+     */
+    void play(int channel, int volume) {
+        poll();
+        Mix_HaltMusic();
+        // The channel is only reserved for music when it is cached; otherwise it may hold a sound effect
+        if (mode != MUSIC_CACHE_OFF) {
+            Mix_HaltChannel(channel);
+        }
+        streaming = false;
+        playChannel = channel;
+        playVolume = volume;
+
+        if (pcm) {
+            Mix_Volume(channel, volume);
+            if (Mix_PlayChannel(channel, pcm, -1) == -1) {
+                std::cout << "Could not play music: " << Mix_GetError() << std::endl;
+            }
+        } else if (stream) {
+            if (Mix_PlayMusic(stream, -1) == -1) {
+                std::cout << "Could not play music: " << Mix_GetError() << std::endl;
+            } else {
+                Mix_VolumeMusic(volume);
+                streaming = true;
+            }
+        }
+    }
+
+    /**
+     * Once per tick while this is the current track: if it is streaming
+     * and decoding has just finished, fade the stream out and the PCM in
+     * (from the top) on the channel play() was given.
+     */
+    void update() {
+        if (!streaming || !decoder.joinable()) return;
+        poll();
+        if (!pcm) return;
+
+        streaming = false;
+        Mix_FadeOutMusic(MUSIC_SWITCH_FADE_MS);
+        Mix_Volume(playChannel, playVolume);
+        if (Mix_FadeInChannel(playChannel, pcm, -1, MUSIC_SWITCH_FADE_MS) == -1) {
+            std::cout << "Could not play music: " << Mix_GetError() << std::endl;
+        }
+    }
+
+    void free() {
+        streaming = false;
+        if (decoder.joinable()) {
+            decoder.join();
+        }
+        if (decodedChunk) {
+            Mix_FreeChunk(decodedChunk);
+            decodedChunk = nullptr;
+        }
+        if (pcm) {
+            Mix_FreeChunk(pcm);
+            pcm = nullptr;
+        }
+#ifndef _WIN32
+        if (mapping) {
+            munmap(mapping, mappingSize);
+            mapping = nullptr;
+        }
+#endif
+        if (stream) {
+            Mix_FreeMusic(stream);
+            stream = nullptr;
+        }
+    }
+};
+
+#endif // MUSIC_CACHE_H
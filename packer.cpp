@@ -0,0 +1,171 @@
+/**
+ * @file packer.cpp
+ * @brief Offline asset packer for the Maze Shooter game
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Decodes every start-up asset once and writes them into a single versioned
+ * archive (see asset_pack.h) that the game memory-maps at launch.
+ * Run from the game directory so the asset paths resolve.
+ * to compile: make packer
+ * usage: ./maze_packer [output.pak]
+ */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "texture_utils.h"
+
+// Must match the engine's texture size range (see main.cpp)
+const int MIN_TEXTURE_SIZE = 32;
+const int MAX_TEXTURE_SIZE = 256;
+
+struct PendingEntry {
+    AssetPackEntry entry;
+    std::vector<Uint8> bytes;
+};
+
+static PendingEntry makeEntry(const std::string& name, AssetType type, int width, int height) {
+    PendingEntry pending;
+    memset(&pending.entry, 0, sizeof(pending.entry));
+    strncpy(pending.entry.name, name.c_str(), sizeof(pending.entry.name) - 1);
+    pending.entry.type = type;
+    pending.entry.width = width;
+    pending.entry.height = height;
+    return pending;
+}
+
+static bool addWallTexture(std::vector<PendingEntry>& entries, const std::string& filename) {
+    SDL_Surface* surface = loadSurfaceARGB8888(filename);
+    if (!surface) return false;
+
+    int size = chooseTextureSize(surface->w, surface->h, MIN_TEXTURE_SIZE, MAX_TEXTURE_SIZE);
+    PendingEntry pending = makeEntry(filename, ASSET_PIXELS, size, size);
+    pending.bytes.resize(size * size * sizeof(Uint32));
+
+    SDL_LockSurface(surface);
+    resampleTexture((const Uint32*)surface->pixels, surface->w, surface->h, surface->pitch / sizeof(Uint32),
+                    (Uint32*)pending.bytes.data(), size, size);
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    entries.push_back(pending);
+    return true;
+}
+
+static bool addImage(std::vector<PendingEntry>& entries, const std::string& filename) {
+    SDL_Surface* surface = loadSurfaceARGB8888(filename);
+    if (!surface) return false;
+
+    PendingEntry pending = makeEntry(filename, ASSET_PIXELS, surface->w, surface->h);
+    pending.bytes.resize(surface->w * surface->h * sizeof(Uint32));
+    copySurfacePixels(surface, (Uint32*)pending.bytes.data());
+    SDL_FreeSurface(surface);
+
+    entries.push_back(pending);
+    return true;
+}
+
+static bool addBlob(std::vector<PendingEntry>& entries, const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << filename << std::endl;
+        return false;
+    }
+
+    PendingEntry pending = makeEntry(filename, ASSET_BLOB, 0, 0);
+    pending.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    entries.push_back(pending);
+    return true;
+}
+
+static Uint64 alignOffset(Uint64 offset) {
+    return (offset + ASSET_PACK_ALIGNMENT - 1) & ~(Uint64)(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static bool writePack(const std::string& path, std::vector<PendingEntry>& entries) {
+    AssetPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.byteOrder = ASSET_PACK_BYTE_ORDER;
+    header.entryCount = entries.size();
+
+    // Lay out payloads after the entry table
+    Uint64 offset = sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry);
+    for (size_t i = 0; i < entries.size(); i++) {
+        offset = alignOffset(offset);
+        entries[i].entry.offset = offset;
+        entries[i].entry.size = entries[i].bytes.size();
+        offset += entries[i].bytes.size();
+    }
+
+    // Write to a temporary file and rename, so a running game never maps a half-written pack
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create " << tempPath << std::endl;
+        return false;
+    }
+
+    out.write((const char*)&header, sizeof(header));
+    for (size_t i = 0; i < entries.size(); i++) {
+        out.write((const char*)&entries[i].entry, sizeof(AssetPackEntry));
+    }
+
+    static const char padding[ASSET_PACK_ALIGNMENT] = {0};
+    for (size_t i = 0; i < entries.size(); i++) {
+        Uint64 position = out.tellp();
+        out.write(padding, entries[i].entry.offset - position);
+        out.write((const char*)entries[i].bytes.data(), entries[i].bytes.size());
+    }
+    out.close();
+
+    if (!out || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::cout << "Wrote " << entries.size() << " assets (" << offset << " bytes) to " << path << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = argc > 1 ? argv[1] : ASSET_PACK_FILE;
+
+    int imgFlags = IMG_INIT_PNG | IMG_INIT_JPG;
+    if (!(IMG_Init(imgFlags) & imgFlags)) {
+        std::cerr << "SDL_image initialization failed: " << IMG_GetError() << std::endl;
+        return -1;
+    }
+
+    std::vector<PendingEntry> entries;
+    bool ok = true;
+
+    for (int i = 0; i < WALL_TEXTURE_COUNT; i++) {
+        ok = addWallTexture(entries, WALL_TEXTURE_FILES[i]) && ok;
+    }
+    for (int i = 0; i < GUN_SPRITE_COUNT; i++) {
+        ok = addImage(entries, GUN_SPRITE_FILES[i]) && ok;
+    }
+    ok = addImage(entries, MENU_BACKGROUND_FILE) && ok;
+    ok = addBlob(entries, FONT_FILE) && ok;
+    ok = addBlob(entries, SHOOT_SOUND_FILE) && ok;
+
+    if (!ok) {
+        std::cerr << "Some assets could not be packed; the game will load them from disk" << std::endl;
+    }
+
+    bool written = writePack(output, entries);
+    IMG_Quit();
+    return written ? 0 : -1;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file present.h
+ * @brief Frame format conversion for presenting without SDL_Renderer
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The engine renders ARGB8888. Window surfaces come in whatever format the
+ * video driver picked, so the common ones are converted here with SSE2 and
+ * anything else falls back to SDL_ConvertPixels.
+ */
+
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <SDL2/SDL.h>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// ARGB8888 -> ABGR8888 (swap red and blue)
+inline void convertRowToABGR(const Uint32* src, Uint32* dst, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i keepMask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i lowMask = _mm_set1_epi32(0x000000FF);
+    for (; i + 4 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i red = _mm_and_si128(_mm_srli_epi32(p, 16), lowMask);
+        __m128i blue = _mm_slli_epi32(_mm_and_si128(p, lowMask), 16);
+        p = _mm_or_si128(_mm_and_si128(p, keepMask), _mm_or_si128(red, blue));
+        _mm_storeu_si128((__m128i*)(dst + i), p);
+    }
+#endif
+    for (; i < count; i++) {
+        Uint32 p = src[i];
+        dst[i] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+    }
+}
+
+// ARGB8888 -> RGB565
+inline void convertRowToRGB565(const Uint32* src, Uint16* dst, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i redMask = _mm_set1_epi32(0xF800);
+    const __m128i greenMask = _mm_set1_epi32(0x07E0);
+    const __m128i blueMask = _mm_set1_epi32(0x001F);
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i p = _mm_loadu_si128((const __m128i*)(src + i + half * 4));
+            __m128i rgb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 8), redMask),
+                          _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 5), greenMask),
+                                       _mm_and_si128(_mm_srli_epi32(p, 3), blueMask)));
+            // Bias into signed range so the saturating pack keeps all 16 bits
+            packed[half] = _mm_sub_epi32(rgb, bias32);
+        }
+        __m128i result = _mm_xor_si128(_mm_packs_epi32(packed[0], packed[1]), bias16);
+        _mm_storeu_si128((__m128i*)(dst + i), result);
+    }
+#endif
+    for (; i < count; i++) {
+        Uint32 p = src[i];
+        dst[i] = (Uint16)(((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F));
+    }
+}
+
+/**
+ * Copy an ARGB8888 frame into a locked surface of any format, clipped to
+ * the smaller of the two sizes.
+ */
+inline void convertFrameToSurface(const Uint32* src, int width, int height, SDL_Surface* surface) {
+    int w = width < surface->w ? width : surface->w;
+    int h = height < surface->h ? height : surface->h;
+
+    switch (surface->format->format) {
+        case SDL_PIXELFORMAT_ARGB8888:
+        case SDL_PIXELFORMAT_RGB888:
+            for (int y = 0; y < h; y++) {
+                memcpy((Uint8*)surface->pixels + y * surface->pitch, src + y * width, w * sizeof(Uint32));
+            }
+            break;
+        case SDL_PIXELFORMAT_ABGR8888:
+        case SDL_PIXELFORMAT_BGR888:
+            for (int y = 0; y < h; y++) {
+                convertRowToABGR(src + y * width, (Uint32*)((Uint8*)surface->pixels + y * surface->pitch), w);
+            }
+            break;
+        case SDL_PIXELFORMAT_RGB565:
+            for (int y = 0; y < h; y++) {
+                convertRowToRGB565(src + y * width, (Uint16*)((Uint8*)surface->pixels + y * surface->pitch), w);
+            }
+            break;
+        default:
+            SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_ARGB8888, src, width * sizeof(Uint32),
+                              surface->format->format, surface->pixels, surface->pitch);
+            break;
+    }
+}
+
+#endif // PRESENT_H
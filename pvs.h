@@ -0,0 +1,316 @@
+/**
+ * @file pvs.h
+ * @brief Bounding box of the potentially visible cells of every empty map cell
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * For each empty cell, rays are cast from its centre and corners in
+ * PVS_RAY_DIRECTIONS directions up to the view distance, and every cell a
+ * ray passes through or stops at counts as visible. This is sampled, not
+ * exact: a cell only seen through a gap narrower than the ray spacing can
+ * be missed. Mazes are mostly corridors, so the set is small and local.
+ *
+ * Because of that sampling only the set's bounding box is kept, one
+ * PvsEntry per cell: a missed cell still lies inside the box unless it is
+ * farther out than every ray in its direction. Wall cells have an empty
+ * box.
+ *
+ * The build runs on all cores and can be cancelled from another thread,
+ * so callers can run it in the background. Results can be cached in a file next to
+ * the map (see save/load); the cache records a checksum of the map cells
+ * and the build parameters and is rebuilt when either changes.
+ *
+ * No SDL dependency, so the command-line tools can use it too.
+ */
+
+#ifndef PVS_H
+#define PVS_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int PVS_RAY_DIRECTIONS = 512;
+const uint32_t PVS_MAX_CELLS = 1024 * 1024;  // Larger maps are not precomputed
+const char PVS_MAGIC[4] = {'M', 'S', 'P', 'V'};
+const uint32_t PVS_VERSION = 2;
+
+// Ray origins inside a cell: centre and four corners, slightly inset
+const int PVS_SAMPLE_POINTS = 5;
+const double PVS_SAMPLE_X[PVS_SAMPLE_POINTS] = {0.5, 0.02, 0.98, 0.02, 0.98};
+const double PVS_SAMPLE_Y[PVS_SAMPLE_POINTS] = {0.5, 0.02, 0.02, 0.98, 0.98};
+
+struct PvsEntry {
+    uint16_t minX, minY;
+    uint16_t sizeX, sizeY;  // 0 for wall cells
+};
+
+struct PvsFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    float maxDistance;
+    uint32_t directions;
+    uint64_t checksum;      // Map cells and dimensions
+};
+
+static_assert(sizeof(PvsEntry) == 8, "PvsEntry layout");
+static_assert(sizeof(PvsFileHeader) == 32, "PvsFileHeader layout");
+
+class VisibilitySet {
+private:
+    uint32_t mapWidth;
+    uint32_t mapHeight;
+    float maxDistance;
+    uint64_t checksum;
+    std::vector<PvsEntry> entries;   // entries[x * height + y]
+    double buildSeconds;
+
+    // Bounding box of the cells reached by the rays of one origin cell
+    struct Bounds {
+        int minX, minY, maxX, maxY;
+    };
+
+    static void mark(Bounds& bounds, int x, int y) {
+        if (x < bounds.minX) bounds.minX = x;
+        if (y < bounds.minY) bounds.minY = y;
+        if (x > bounds.maxX) bounds.maxX = x;
+        if (y > bounds.maxY) bounds.maxY = y;
+    }
+
+    // Grid walk from (posX, posY), marking every cell up to and including the first wall
+    template<typename Cursor>
+    void walk(Cursor& cursor, Bounds& bounds, double posX, double posY, double rayDirX, double rayDirY) {
+        int mapX = (int)posX;
+        int mapY = (int)posY;
+        double deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1 / rayDirX);
+        double deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1 / rayDirY);
+        int stepX = rayDirX < 0 ? -1 : 1;
+        int stepY = rayDirY < 0 ? -1 : 1;
+        double sideDistX = rayDirX < 0 ? (posX - mapX) * deltaDistX : (mapX + 1.0 - posX) * deltaDistX;
+        double sideDistY = rayDirY < 0 ? (posY - mapY) * deltaDistY : (mapY + 1.0 - posY) * deltaDistY;
+
+        for (;;) {
+            double distance;
+            if (sideDistX < sideDistY) {
+                distance = sideDistX;
+                sideDistX += deltaDistX;
+                mapX += stepX;
+            } else {
+                distance = sideDistY;
+                sideDistY += deltaDistY;
+                mapY += stepY;
+            }
+            if (distance > maxDistance || mapX < 0 || mapY < 0 || mapX >= (int)mapWidth || mapY >= (int)mapHeight) {
+                break;
+            }
+            mark(bounds, mapX, mapY);
+            if (cursor.solid(mapX, mapY)) break;
+        }
+    }
+
+    template<typename Map>
+    void buildColumns(Map& map, int firstX, int lastX, const std::atomic<bool>* cancel) {
+        typename Map::Cursor cursor(map);
+        for (int x = firstX; x < lastX; x++) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return;
+            for (int y = 0; y < (int)mapHeight; y++) {
+                PvsEntry& entry = entries[(size_t)x * mapHeight + y];
+                memset(&entry, 0, sizeof(entry));
+                if (cursor.solid(x, y)) continue;
+
+                Bounds bounds = {x, y, x, y};
+                for (int s = 0; s < PVS_SAMPLE_POINTS; s++) {
+                    for (int d = 0; d < PVS_RAY_DIRECTIONS; d++) {
+                        double angle = 2 * M_PI * (d + 0.5) / PVS_RAY_DIRECTIONS;
+                        walk(cursor, bounds, x + PVS_SAMPLE_X[s], y + PVS_SAMPLE_Y[s], std::cos(angle), std::sin(angle));
+                    }
+                }
+
+                entry.minX = bounds.minX;
+                entry.minY = bounds.minY;
+                entry.sizeX = bounds.maxX - bounds.minX + 1;
+                entry.sizeY = bounds.maxY - bounds.minY + 1;
+            }
+        }
+    }
+
+    template<typename Map>
+    static uint64_t mapChecksum(Map& map, uint32_t width, uint32_t height) {
+        // FNV-1a over the dimensions and every cell
+        uint64_t hash = 14695981039346656037ULL;
+        uint32_t dimensions[2] = {width, height};
+        const uint8_t* bytes = (const uint8_t*)dimensions;
+        for (size_t i = 0; i < sizeof(dimensions); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        typename Map::Cursor cursor(map);
+        for (uint32_t x = 0; x < width; x++) {
+            for (uint32_t y = 0; y < height; y++) {
+                hash = (hash ^ cursor.at(x, y)) * 1099511628211ULL;
+            }
+        }
+        return hash;
+    }
+
+public:
+    VisibilitySet() : mapWidth(0), mapHeight(0), maxDistance(0), checksum(0), buildSeconds(0) {}
+
+    bool isBuilt() const {
+        return !entries.empty();
+    }
+
+    void clear() {
+        entries.clear();
+        entries.shrink_to_fit();
+        mapWidth = mapHeight = 0;
+    }
+
+    static bool fits(uint32_t width, uint32_t height) {
+        return (uint64_t)width * height <= PVS_MAX_CELLS && width <= 65535 && height <= 65535;
+    }
+
+    /**
+     * Compute the set for every empty cell of map (width x height cells,
+     * read through Map::Cursor solid()/at()), seeing up to viewDistance.
+     * Returns false (set left empty) if the map is too big or *cancel
+     * became true during the build.
+     */
+    template<typename Map>
+    bool build(Map& map, uint32_t width, uint32_t height, double viewDistance,
+               const std::atomic<bool>* cancel = nullptr) {
+        clear();
+        if (!fits(width, height)) {
+            return false;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        mapWidth = width;
+        mapHeight = height;
+        maxDistance = (float)viewDistance;
+        checksum = mapChecksum(map, width, height);
+        entries.resize((size_t)width * height);
+
+        int threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount < 1) threadCount = 1;
+        if (threadCount > (int)width) threadCount = width;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; t++) {
+            int firstX = (int)((uint64_t)width * t / threadCount);
+            int lastX = (int)((uint64_t)width * (t + 1) / threadCount);
+            threads.push_back(std::thread([this, &map, firstX, lastX, cancel]() {
+                buildColumns(map, firstX, lastX, cancel);
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        if (cancel && cancel->load()) {
+            clear();
+            return false;
+        }
+        buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    /**
+     * Is cell (toX, toY) inside the bounding box of everything sampled
+     * from cell (fromX, fromY)? Cells outside it cannot be seen from there
+     * unless every ray in their direction stopped short of them. Always
+     * true from outside the map.
+     */
+    bool withinBounds(int fromX, int fromY, int toX, int toY) const {
+        if (fromX < 0 || fromY < 0 || fromX >= (int)mapWidth || fromY >= (int)mapHeight) return true;
+        const PvsEntry& entry = entries[(size_t)fromX * mapHeight + fromY];
+        int localX = toX - entry.minX;
+        int localY = toY - entry.minY;
+        return localX >= 0 && localY >= 0 && localX < entry.sizeX && localY < entry.sizeY;
+    }
+
+    size_t memoryUsed() const {
+        return entries.size() * sizeof(PvsEntry);
+    }
+
+    bool save(const std::string& path) const {
+        if (!isBuilt()) return false;
+        FILE* out = fopen(path.c_str(), "wb");
+        if (!out) return false;
+
+        PvsFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, PVS_MAGIC, sizeof(PVS_MAGIC));
+        header.version = PVS_VERSION;
+        header.width = mapWidth;
+        header.height = mapHeight;
+        header.maxDistance = maxDistance;
+        header.directions = PVS_RAY_DIRECTIONS;
+        header.checksum = checksum;
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                  fwrite(entries.data(), sizeof(PvsEntry), entries.size(), out) == entries.size();
+        ok = fclose(out) == 0 && ok;
+        return ok;
+    }
+
+    /**
+     * Load a cached set. Fails (leaving the set empty) unless it was built
+     * for the same cells, size and view distance.
+     */
+    template<typename Map>
+    bool load(const std::string& path, Map& map, uint32_t width, uint32_t height, double viewDistance) {
+        clear();
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in) return false;
+
+        PvsFileHeader header;
+        bool ok = fread(&header, sizeof(header), 1, in) == 1 &&
+                  memcmp(header.magic, PVS_MAGIC, sizeof(PVS_MAGIC)) == 0 && header.version == PVS_VERSION &&
+                  header.width == width && header.height == height && header.maxDistance == (float)viewDistance &&
+                  header.directions == (uint32_t)PVS_RAY_DIRECTIONS && (uint64_t)width * height <= PVS_MAX_CELLS &&
+                  header.checksum == mapChecksum(map, width, height);
+        if (ok) {
+            entries.resize((size_t)width * height);
+            ok = fread(entries.data(), sizeof(PvsEntry), entries.size(), in) == entries.size() &&
+                 fgetc(in) == EOF;
+        }
+        fclose(in);
+        if (!ok) {
+            clear();
+            return false;
+        }
+        mapWidth = width;
+        mapHeight = height;
+        maxDistance = (float)viewDistance;
+        checksum = header.checksum;
+        buildSeconds = 0;
+        return true;
+    }
+
+    void printStats() const {
+        if (!isBuilt()) return;
+        uint64_t emptyCells = 0, boxCells = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].sizeX == 0) continue;
+            emptyCells++;
+            boxCells += (uint64_t)entries[i].sizeX * entries[i].sizeY;
+        }
+        std::cout << "PVS: " << mapWidth << "x" << mapHeight << ", " << emptyCells << " empty cells, "
+                  << (emptyCells ? (double)boxCells / emptyCells : 0) << " cells per box, "
+                  << memoryUsed() / 1024 << " KB";
+        if (buildSeconds > 0) {
+            std::cout << ", built in " << buildSeconds * 1000 << " ms";
+        } else {
+            std::cout << ", loaded from cache";
+        }
+        std::cout << std::endl;
+    }
+};
+
+#endif // PVS_H
@@ -0,0 +1,192 @@
+/**
+ * @file raycast.h
+ * @brief Grid DDA shared by the renderer and the tools
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * castRay walks the grid from the player along one ray until it enters a
+ * wall cell. It is templated on the map type: anything with a Cursor that
+ * has solid(x, y) (is the cell a wall) and at(x, y) (its texture id) works
+ * (GameMap, ChunkedMap). Each step only tests solid(); the texture id is
+ * read once, at the hit. Maps that know where their empty regions are let
+ * rays leap across them (see emptyShift below).
+ */
+
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <cmath>
+#include <cstdint>
+
+const double RAY_NO_LIMIT = 1e30;
+
+struct RayHit {
+    int mapX;
+    int mapY;
+    int side;             // 0 = crossed an x grid line, 1 = a y grid line
+    double perpWallDist;  // Distance to the wall along the view direction
+    uint8_t cell;         // Wall texture id, 0 if no wall within maxDistance
+    int steps;            // Cells visited plus leaps over empty regions
+};
+
+/**
+ * How many of the crossings first + n * delta (n = low .. high - 1) come
+ * before limit; inclusive counts ties too. Starts from a division and
+ * fixes it up with the same expression the DDA loop compares, so the
+ * result is exact.
+ */
+inline int crossingsBefore(double first, double delta, double limit, bool inclusive, int low, int high) {
+    double estimate = std::floor((limit - first) / delta) + 1;
+    int n = estimate < low ? low : (estimate > high ? high : (int)estimate);
+    while (n > low) {
+        double t = first + (n - 1) * delta;
+        if (inclusive ? t <= limit : t < limit) break;
+        n--;
+    }
+    while (n < high) {
+        double t = first + n * delta;
+        if (!(inclusive ? t <= limit : t < limit)) break;
+        n++;
+    }
+    return n;
+}
+
+// Default castRay visitor: does nothing and compiles away
+struct NoCellVisit {
+    void operator()(int, int) const {}
+};
+
+/**
+ * Walk the grid from (posX, posY) along rayDir until the ray enters a wall
+ * cell. sideDist is computed as first crossing + crossings * deltaDist
+ * rather than accumulated, so the loop can jump ahead to any crossing and
+ * land on exactly the state stepping would have reached.
+ *
+ * Map::Cursor provides solid(x, y), at(x, y) and emptyShift(x, y): the
+ * log2 size of an aligned, wall-free square around the cell (0 if none).
+ * When the current cell is in such a square, the ray leaps to the last
+ * crossing inside it, and the next step leaves it. The hit is the same
+ * as walking cell by cell.
+ *
+ * The walk gives up once the next grid crossing is farther than
+ * maxDistance (measured like perpWallDist, for a unit view direction);
+ * the result then has cell 0 and perpWallDist = maxDistance. This bounds
+ * the cost of every ray whatever the map looks like.
+ *
+ * visit(x, y) is called for the start cell and then once per step, with
+ * each cell stepped into and the landing cell of each leap.
+ */
+template<typename Map, typename Visit = NoCellVisit>
+inline RayHit castRay(Map& map, double posX, double posY, double rayDirX, double rayDirY,
+                      double maxDistance = RAY_NO_LIMIT, Visit visit = Visit()) {
+    typename Map::Cursor cursor(map);
+    RayHit hit;
+    hit.mapX = int(posX);
+    hit.mapY = int(posY);
+    hit.side = 0;
+    hit.steps = 0;
+
+    double deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1 / rayDirX);
+    double deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1 / rayDirY);
+
+    int stepX, stepY;
+    double firstSideDistX, firstSideDistY;
+
+    if (rayDirX < 0) {
+        stepX = -1;
+        firstSideDistX = (posX - hit.mapX) * deltaDistX;
+    } else {
+        stepX = 1;
+        firstSideDistX = (hit.mapX + 1.0 - posX) * deltaDistX;
+    }
+
+    if (rayDirY < 0) {
+        stepY = -1;
+        firstSideDistY = (posY - hit.mapY) * deltaDistY;
+    } else {
+        stepY = 1;
+        firstSideDistY = (hit.mapY + 1.0 - posY) * deltaDistY;
+    }
+
+    int startX = hit.mapX, startY = hit.mapY;
+    int crossedX = 0, crossedY = 0;  // Grid lines crossed so far
+    visit(startX, startY);
+
+    for (;;) {
+        int shift = cursor.emptyShift(hit.mapX, hit.mapY);
+        if (shift > 0) {
+            // First cell outside the empty square along each axis
+            int exitX = stepX > 0 ? ((hit.mapX >> shift) + 1) << shift : ((hit.mapX >> shift) << shift) - 1;
+            int exitY = stepY > 0 ? ((hit.mapY >> shift) + 1) << shift : ((hit.mapY >> shift) << shift) - 1;
+            int lastX = std::abs(exitX - startX) - 1;
+            int lastY = std::abs(exitY - startY) - 1;
+            double exitDistX = firstSideDistX + lastX * deltaDistX;
+            double exitDistY = firstSideDistY + lastY * deltaDistY;
+            if (exitDistX < exitDistY) {
+                crossedY = crossingsBefore(firstSideDistY, deltaDistY, exitDistX, true, crossedY, lastY);
+                crossedX = lastX;
+            } else {
+                crossedX = crossingsBefore(firstSideDistX, deltaDistX, exitDistY, false, crossedX, lastX);
+                crossedY = lastY;
+            }
+            hit.mapX = startX + stepX * crossedX;
+            hit.mapY = startY + stepY * crossedY;
+            hit.steps++;
+            visit(hit.mapX, hit.mapY);
+        }
+
+        double sideDistX = firstSideDistX + crossedX * deltaDistX;
+        double sideDistY = firstSideDistY + crossedY * deltaDistY;
+        if ((sideDistX < sideDistY ? sideDistX : sideDistY) > maxDistance) {
+            hit.cell = 0;
+            hit.perpWallDist = maxDistance;
+            return hit;
+        }
+        if (sideDistX < sideDistY) {
+            crossedX++;
+            hit.mapX += stepX;
+            hit.side = 0;
+        } else {
+            crossedY++;
+            hit.mapY += stepY;
+            hit.side = 1;
+        }
+        hit.steps++;
+        visit(hit.mapX, hit.mapY);
+
+        if (cursor.solid(hit.mapX, hit.mapY)) break;
+    }
+    hit.cell = cursor.at(hit.mapX, hit.mapY);
+
+    if (hit.side == 0) {
+        hit.perpWallDist = (hit.mapX - posX + (1 - stepX) / 2) / rayDirX;
+    } else {
+        hit.perpWallDist = (hit.mapY - posY + (1 - stepY) / 2) / rayDirY;
+    }
+    return hit;
+}
+
+inline bool sameFace(const RayHit& a, const RayHit& b) {
+    return a.cell != 0 && b.cell != 0 && a.mapX == b.mapX && a.mapY == b.mapY && a.side == b.side;
+}
+
+/**
+ * The hit of a ray that is known to end on face's wall face, e.g. one lying
+ * between two rays that both hit it with nothing in between. Same result
+ * as castRay() for that ray, without walking the grid.
+ */
+inline RayHit faceHit(const RayHit& face, double posX, double posY, double rayDirX, double rayDirY) {
+    RayHit hit = face;
+    hit.steps = 0;
+    if (hit.side == 0) {
+        int stepX = rayDirX < 0 ? -1 : 1;
+        hit.perpWallDist = (hit.mapX - posX + (1 - stepX) / 2) / rayDirX;
+    } else {
+        int stepY = rayDirY < 0 ? -1 : 1;
+        hit.perpWallDist = (hit.mapY - posY + (1 - stepY) / 2) / rayDirY;
+    }
+    return hit;
+}
+
+#endif // RAYCAST_H
@@ -0,0 +1,176 @@
+/**
+ * @file sample_bank.h
+ * @brief Sound effects converted once to the device format, in one buffer
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Every effect is decoded from WAV and converted to the exact format of
+ * the open audio device (rate, sample format, channels) at load time.
+ * Resampling uses the highest quality mode SDL offers; the hint is set
+ * only while the bank converts, and the previous value restored. All converted
+ * samples live in one shared, 16-byte aligned buffer, and their Mix_Chunks
+ * point into it (Mix_QuickLoad_RAW). Playback through SDL_mixer or the
+ * voice mixer is then a straight mix, with no per-chunk conversion or
+ * allocation.
+ *
+ * Usage: begin(), load() each effect, finish(), then chunk(index).
+ */
+
+#ifndef SAMPLE_BANK_H
+#define SAMPLE_BANK_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const size_t SAMPLE_ALIGNMENT = 16;
+
+class SampleBank {
+private:
+    struct Sample {
+        std::string name;
+        size_t offset;
+        Uint32 length;
+        Mix_Chunk* chunk;
+    };
+
+    std::vector<Uint8> storage;
+    std::vector<Sample> samples;
+    int frequency;
+    Uint16 format;
+    int channels;
+    size_t sourceBytes;
+
+    // Sets the "best" resampling hint for its lifetime, then restores the old value
+    class ResamplingHint {
+    private:
+        std::string previous;
+        bool hadPrevious;
+
+    public:
+        ResamplingHint() : hadPrevious(false) {
+#ifdef SDL_HINT_AUDIO_RESAMPLING_MODE
+            const char* value = SDL_GetHint(SDL_HINT_AUDIO_RESAMPLING_MODE);
+            if (value) {
+                previous = value;  // Copied: SDL frees the string when the hint changes
+                hadPrevious = true;
+            }
+            SDL_SetHint(SDL_HINT_AUDIO_RESAMPLING_MODE, "best");
+#endif
+        }
+
+        ~ResamplingHint() {
+#ifdef SDL_HINT_AUDIO_RESAMPLING_MODE
+            SDL_SetHint(SDL_HINT_AUDIO_RESAMPLING_MODE, hadPrevious ? previous.c_str() : nullptr);
+#endif
+        }
+    };
+
+public:
+    SampleBank() : frequency(0), format(0), channels(0), sourceBytes(0) {}
+
+    ~SampleBank() {
+        clear();
+    }
+
+    // Takes the target format from the open audio device
+    bool begin() {
+        clear();
+        if (!Mix_QuerySpec(&frequency, &format, &channels)) {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Decode a WAV from src (closed afterwards) and append it in the device
+     * format. Returns the sample's index, or -1 on failure.
+     */
+    int load(const std::string& name, SDL_RWops* src) {
+        if (!src) {
+            std::cout << "Could not open sound " << name << std::endl;
+            return -1;
+        }
+
+        SDL_AudioSpec spec;
+        Uint8* wavData = nullptr;
+        Uint32 wavLength = 0;
+        if (!SDL_LoadWAV_RW(src, 1, &spec, &wavData, &wavLength)) {
+            std::cout << "Could not load sound " << name << ": " << SDL_GetError() << std::endl;
+            return -1;
+        }
+
+        ResamplingHint hint;
+        SDL_AudioCVT cvt;
+        if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, format, channels, frequency) < 0) {
+            std::cout << "Cannot convert sound " << name << ": " << SDL_GetError() << std::endl;
+            SDL_FreeWAV(wavData);
+            return -1;
+        }
+
+        // Convert in place at the end of the bank (needs len * len_mult bytes)
+        size_t offset = (storage.size() + SAMPLE_ALIGNMENT - 1) & ~(SAMPLE_ALIGNMENT - 1);
+        cvt.len = wavLength;
+        storage.resize(offset + (size_t)wavLength * cvt.len_mult);
+        cvt.buf = storage.data() + offset;
+        memcpy(cvt.buf, wavData, wavLength);
+        SDL_FreeWAV(wavData);
+
+        if (cvt.needed && SDL_ConvertAudio(&cvt) < 0) {
+            std::cout << "Cannot convert sound " << name << ": " << SDL_GetError() << std::endl;
+            storage.resize(offset);
+            return -1;
+        }
+        Uint32 length = cvt.needed ? cvt.len_cvt : wavLength;
+        storage.resize(offset + length);
+        sourceBytes += wavLength;
+
+        Sample sample;
+        sample.name = name;
+        sample.offset = offset;
+        sample.length = length;
+        sample.chunk = nullptr;
+        samples.push_back(sample);
+        return (int)samples.size() - 1;
+    }
+
+    // Trim the buffer, create the chunks now that it no longer moves, and report memory
+    void finish() {
+        storage.shrink_to_fit();
+        for (size_t i = 0; i < samples.size(); i++) {
+            samples[i].chunk = Mix_QuickLoad_RAW(storage.data() + samples[i].offset, samples[i].length);
+        }
+        std::cout << "Sample bank: " << samples.size() << " sounds, " << storage.size() / 1024.0 << " KB at "
+                  << frequency << " Hz, " << SDL_AUDIO_BITSIZE(format) << "-bit, " << channels
+                  << " channels (" << sourceBytes / 1024.0 << " KB as loaded)" << std::endl;
+    }
+
+    Mix_Chunk* chunk(int index) const {
+        if (index < 0 || index >= (int)samples.size()) return nullptr;
+        return samples[index].chunk;
+    }
+
+    // Bytes of converted samples held (alignment padding included)
+    size_t memoryUsed() const {
+        return storage.size();
+    }
+
+    // Sounds must no longer be playing
+    void clear() {
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (samples[i].chunk) {
+                Mix_FreeChunk(samples[i].chunk);  // Frees the chunk, not the bank's memory
+            }
+        }
+        samples.clear();
+        storage.clear();
+        storage.shrink_to_fit();
+        sourceBytes = 0;
+    }
+};
+
+#endif // SAMPLE_BANK_H
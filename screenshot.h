@@ -0,0 +1,121 @@
+/**
+ * @file screenshot.h
+ * @brief Screenshots encoded to PNG on a worker thread
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Capturing costs the frame one memcpy into a pooled buffer and a
+ * time() call; the file name, PNG encoding and file I/O happen on the
+ * worker. All SCREENSHOT_MAX_BUFFERS buffers are allocated by start(), so
+ * the render thread never allocates. A burst that outruns the encoder
+ * skips shots once every buffer is queued, and the worker reports how
+ * many.
+ */
+
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+#include "frame_pool.h"
+
+const int SCREENSHOT_MAX_BUFFERS = 8;  // 1.9 MB each at 800x600
+
+class ScreenshotWriter {
+private:
+    FramePool pool;
+    std::thread worker;
+    // Per pool buffer, written by capture() before submit
+    time_t shotTimes[SCREENSHOT_MAX_BUFFERS];
+    int shotNumbers[SCREENSHOT_MAX_BUFFERS];
+    std::atomic<int> skippedShots;
+    int width;
+    int height;
+    int shotCount;
+    bool running;
+
+    void workerLoop() {
+        for (;;) {
+            int index = pool.waitReady();
+            if (index < 0) break;
+
+            struct tm local;
+            char stamp[32];
+#ifdef _WIN32
+            localtime_s(&local, &shotTimes[index]);
+#else
+            localtime_r(&shotTimes[index], &local);
+#endif
+            strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+            char filename[64];
+            snprintf(filename, sizeof(filename), "screenshot_%s_%03d.png", stamp, shotNumbers[index]);
+
+            SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pool.buffer(index), width, height, 32,
+                                                                      width * sizeof(Uint32), SDL_PIXELFORMAT_ARGB8888);
+            if (surface) {
+                if (IMG_SavePNG(surface, filename) == 0) {
+                    std::cout << "Saved screenshot " << filename << std::endl;
+                } else {
+                    std::cerr << "Failed to save " << filename << ": " << IMG_GetError() << std::endl;
+                }
+                SDL_FreeSurface(surface);
+            }
+            pool.release(index);
+
+            int skipped = skippedShots.exchange(0);
+            if (skipped > 0) {
+                std::cerr << skipped << " screenshots skipped: " << SCREENSHOT_MAX_BUFFERS << " were still encoding" << std::endl;
+            }
+        }
+    }
+
+public:
+    ScreenshotWriter() : skippedShots(0), width(0), height(0), shotCount(0), running(false) {}
+
+    ~ScreenshotWriter() {
+        stop();
+    }
+
+    void start(int frameWidth, int frameHeight) {
+        width = frameWidth;
+        height = frameHeight;
+        pool.allocate(SCREENSHOT_MAX_BUFFERS, width * height);
+        worker = std::thread(&ScreenshotWriter::workerLoop, this);
+        running = true;
+    }
+
+    // Render thread: copy the frame and queue it for encoding
+    void capture(const Uint32* pixels) {
+        if (!running) return;
+
+        int index = pool.tryAcquire();
+        if (index < 0) {
+            skippedShots++;
+            return;
+        }
+
+        shotTimes[index] = time(nullptr);
+        shotNumbers[index] = shotCount++ % 1000;
+        memcpy(pool.buffer(index), pixels, width * height * sizeof(Uint32));
+        pool.submit(index);
+    }
+
+    void stop() {
+        if (!running) return;
+
+        // Finish the queued shots before exiting
+        pool.close();
+        worker.join();
+        running = false;
+    }
+};
+
+#endif // SCREENSHOT_H
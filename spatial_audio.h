@@ -0,0 +1,303 @@
+/**
+ * @file spatial_audio.h
+ * @brief Sound sources placed on the map, heard relative to the player
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * Each source plays on a VoiceMixer voice whose gains are refreshed once per
+ * game tick from the listener position and view direction:
+ *
+ *   - inverse distance attenuation, silent beyond SOUND_MAX_DISTANCE
+ *   - constant-power panning along the camera plane (screen left/right)
+ *   - occlusion from a grid DDA between listener and source; every wall
+ *     cell crossed multiplies the gain by OCCLUSION_GAIN_PER_WALL
+ *
+ * Occlusion rays are the expensive part, so at most OCCLUSION_RAYS_PER_TICK
+ * are cast per tick, round-robin over the sources; the others keep their
+ * last result. Gains change gradually since results are smoothed. Sources
+ * outside the bounding box of the listener cell's sampled visible set
+ * (pvs.h) skip the ray and count as fully occluded.
+ *
+ * With HRTF enabled, panning is replaced by a spherical-head model:
+ * Woodworth interaural time difference (the far ear is delayed by up to
+ * ~0.66 ms), a level difference for the head shadow, and a slight damping
+ * of sources behind the listener. There is no measured HRIR set to
+ * convolve with, so this is the parametric approximation of one.
+ */
+
+#ifndef SPATIAL_AUDIO_H
+#define SPATIAL_AUDIO_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <cmath>
+#include <iostream>
+
+#include "voice_mixer.h"
+
+const int MAX_SOUND_SOURCES = 128;
+const int OCCLUSION_RAYS_PER_TICK = 16;
+const int MAX_OCCLUDING_WALLS = 4;
+const float OCCLUSION_GAIN_PER_WALL = 0.4f;
+const float OCCLUSION_SMOOTHING = 0.5f;       // Fraction of the way to a new result per trace
+const float SOUND_REFERENCE_DISTANCE = 1.5f;  // Cells at which a source plays at full volume
+const float SOUND_MAX_DISTANCE = 32.0f;
+const float HEAD_RADIUS = 0.0875f;            // Meters
+const float SPEED_OF_SOUND = 343.0f;          // Meters per second
+
+/**
+ * Walk the grid from one point to another and count wall cells crossed,
+ * stopping at maxWalls. The cells holding either end point are not counted.
+ * isWall(x, y) must be safe for any cell on the segment.
+ */
+template<typename IsWall>
+int countOccluders(const IsWall& isWall, double fromX, double fromY, double toX, double toY, int maxWalls) {
+    int mapX = (int)fromX;
+    int mapY = (int)fromY;
+    int targetX = (int)toX;
+    int targetY = (int)toY;
+
+    double rayDirX = toX - fromX;
+    double rayDirY = toY - fromY;
+    double deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1 / rayDirX);
+    double deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1 / rayDirY);
+
+    int stepX = rayDirX < 0 ? -1 : 1;
+    int stepY = rayDirY < 0 ? -1 : 1;
+    double sideDistX = rayDirX < 0 ? (fromX - mapX) * deltaDistX : (mapX + 1.0 - fromX) * deltaDistX;
+    double sideDistY = rayDirY < 0 ? (fromY - mapY) * deltaDistY : (mapY + 1.0 - fromY) * deltaDistY;
+
+    // A straight segment visits exactly this many cells after the first
+    int steps = std::abs(targetX - mapX) + std::abs(targetY - mapY);
+    int walls = 0;
+    for (int i = 0; i < steps && walls < maxWalls; i++) {
+        if (sideDistX < sideDistY) {
+            sideDistX += deltaDistX;
+            mapX += stepX;
+        } else {
+            sideDistY += deltaDistY;
+            mapY += stepY;
+        }
+        if ((mapX != targetX || mapY != targetY) && isWall(mapX, mapY)) {
+            walls++;
+        }
+    }
+    return walls;
+}
+
+struct SoundSource {
+    double x, y;
+    VoiceHandle voice;
+    int volume;             // 0..128
+    Uint32 endTicks;        // When the sound has finished playing
+    float occlusionGain;    // Smoothed, 1 = unobstructed
+    bool active;
+};
+
+struct SpatialParams {
+    float distance;
+    float gainLeft;
+    float gainRight;
+    Uint16 delayLeft;
+    Uint16 delayRight;
+};
+
+class SpatialAudio {
+private:
+    VoiceMixer* mixer;
+    SoundSource sources[MAX_SOUND_SOURCES];
+    int nextOcclusionSource;
+    bool hrtf;
+
+    // Listener, from the last update()
+    double listenerX, listenerY;
+    double forwardX, forwardY;
+    double rightX, rightY;
+
+    // Statistics
+    Uint64 ticks;
+    Uint64 sourceTicks;
+    Uint64 occlusionRays;
+    Uint64 occlusionCulled;
+
+    SpatialParams spatialize(const SoundSource& source) const {
+        SpatialParams params;
+        double dx = source.x - listenerX;
+        double dy = source.y - listenerY;
+        double distance = std::sqrt(dx * dx + dy * dy);
+        params.distance = (float)distance;
+        params.delayLeft = 0;
+        params.delayRight = 0;
+
+        float attenuation = 0.0f;
+        if (distance < SOUND_MAX_DISTANCE) {
+            attenuation = distance <= SOUND_REFERENCE_DISTANCE ? 1.0f : SOUND_REFERENCE_DISTANCE / (float)distance;
+        }
+        float gain = source.volume / (float)MIX_MAX_VOLUME * attenuation * source.occlusionGain;
+
+        // Direction relative to the view: side -1 (left) .. 1 (right), front -1 .. 1
+        float side = 0.0f;
+        float front = 1.0f;
+        if (distance > 1e-3) {
+            side = (float)((dx * rightX + dy * rightY) / distance);
+            front = (float)((dx * forwardX + dy * forwardY) / distance);
+        }
+        if (side > 1.0f) side = 1.0f;
+        if (side < -1.0f) side = -1.0f;
+
+        if (!hrtf) {
+            float angle = (side + 1.0f) * (float)M_PI / 4.0f;
+            params.gainLeft = gain * std::cos(angle);
+            params.gainRight = gain * std::sin(angle);
+            return params;
+        }
+
+        // Woodworth: ITD = r / c * (theta + sin(theta)), theta the lateral angle
+        float theta = std::asin(side);
+        float itdSeconds = HEAD_RADIUS / SPEED_OF_SOUND * (std::fabs(theta) + std::fabs(side));
+        Uint16 delay = (Uint16)(itdSeconds * mixer->sampleRate() + 0.5f);
+
+        // Head shadow on the far ear (about -6 dB at 90 degrees), damping behind
+        float farGain = gain * (1.0f - 0.5f * std::fabs(side));
+        float rear = front < 0.0f ? 1.0f + 0.3f * front : 1.0f;
+        if (side >= 0.0f) {
+            params.gainRight = gain * rear;
+            params.gainLeft = farGain * rear;
+            params.delayLeft = delay;
+        } else {
+            params.gainLeft = gain * rear;
+            params.gainRight = farGain * rear;
+            params.delayRight = delay;
+        }
+        return params;
+    }
+
+    void applyParams(SoundSource& source) {
+        SpatialParams params = spatialize(source);
+        mixer->update(source.voice, (Sint16)(params.gainLeft * VOICE_GAIN_ONE), (Sint16)(params.gainRight * VOICE_GAIN_ONE),
+                      params.distance, params.delayLeft, params.delayRight);
+    }
+
+    /**
+     * IsWall also answers potentiallyVisible(fromX, fromY, toX, toY) for
+     * cells. When it is false the source is treated as behind the maximum
+     * number of walls without casting the ray, so it should only be false
+     * for cells that are (almost) certainly hidden.
+     */
+    template<typename IsWall>
+    float traceOcclusion(const IsWall& isWall, const SoundSource& source) {
+        if (!isWall.potentiallyVisible((int)listenerX, (int)listenerY, (int)source.x, (int)source.y)) {
+            occlusionCulled++;
+            return std::pow(OCCLUSION_GAIN_PER_WALL, (float)MAX_OCCLUDING_WALLS);
+        }
+        occlusionRays++;
+        int walls = countOccluders(isWall, listenerX, listenerY, source.x, source.y, MAX_OCCLUDING_WALLS);
+        return std::pow(OCCLUSION_GAIN_PER_WALL, (float)walls);
+    }
+
+public:
+    SpatialAudio() : mixer(nullptr), nextOcclusionSource(0), hrtf(false),
+                     listenerX(0), listenerY(0), forwardX(1), forwardY(0), rightX(0), rightY(1),
+                     ticks(0), sourceTicks(0), occlusionRays(0), occlusionCulled(0) {
+        memset(sources, 0, sizeof(sources));
+    }
+
+    void init(VoiceMixer* voiceMixer) {
+        mixer = voiceMixer;
+    }
+
+    void setHrtf(bool enabled) {
+        hrtf = enabled;
+    }
+
+    /**
+     * Play chunk from map position (x, y). The first occlusion trace is done
+     * right away so the sound starts at the right level. Returns false if
+     * every source slot is busy or the mixer refused the voice.
+     */
+    template<typename IsWall>
+    bool playAt(const IsWall& isWall, const Mix_Chunk* chunk, double x, double y, int volume, int priority = 0) {
+        if (!mixer || !mixer->isAttached() || !chunk) return false;
+
+        SoundSource* source = nullptr;
+        for (int i = 0; i < MAX_SOUND_SOURCES; i++) {
+            if (!sources[i].active) {
+                source = &sources[i];
+                break;
+            }
+        }
+        if (!source) return false;
+
+        source->x = x;
+        source->y = y;
+        source->volume = volume;
+        source->occlusionGain = traceOcclusion(isWall, *source);
+
+        // Start silent; the update queued right behind sets the real gains
+        SpatialParams params = spatialize(*source);
+        source->voice = mixer->play(chunk, 0, 0.0f, priority, params.distance);
+        if (source->voice == 0) return false;
+        applyParams(*source);
+
+        Uint32 frames = chunk->alen / (2 * sizeof(Sint16));
+        source->endTicks = SDL_GetTicks() + frames * 1000 / mixer->sampleRate() + 50;
+        source->active = true;
+        return true;
+    }
+
+    /**
+     * Once per tick: move the listener, refresh a bounded number of
+     * occlusion results and update every active voice.
+     */
+    template<typename IsWall>
+    void update(const IsWall& isWall, double posX, double posY, double dirX, double dirY, double planeX, double planeY) {
+        listenerX = posX;
+        listenerY = posY;
+        double dirLength = std::sqrt(dirX * dirX + dirY * dirY);
+        double planeLength = std::sqrt(planeX * planeX + planeY * planeY);
+        forwardX = dirX / dirLength;
+        forwardY = dirY / dirLength;
+        rightX = planeX / planeLength;
+        rightY = planeY / planeLength;
+
+        Uint32 now = SDL_GetTicks();
+        int active = 0;
+        for (int i = 0; i < MAX_SOUND_SOURCES; i++) {
+            if (sources[i].active && (int)(now - sources[i].endTicks) >= 0) {
+                sources[i].active = false;
+            }
+            if (sources[i].active) active++;
+        }
+        if (active == 0) return;
+        ticks++;
+        sourceTicks += active;
+
+        // Round-robin occlusion, bounded per tick
+        int budget = OCCLUSION_RAYS_PER_TICK;
+        for (int n = 0; n < MAX_SOUND_SOURCES && budget > 0; n++) {
+            SoundSource& source = sources[nextOcclusionSource];
+            nextOcclusionSource = (nextOcclusionSource + 1) % MAX_SOUND_SOURCES;
+            if (!source.active) continue;
+
+            float target = traceOcclusion(isWall, source);
+            source.occlusionGain += (target - source.occlusionGain) * OCCLUSION_SMOOTHING;
+            budget--;
+        }
+
+        for (int i = 0; i < MAX_SOUND_SOURCES; i++) {
+            if (sources[i].active) {
+                applyParams(sources[i]);
+            }
+        }
+    }
+
+    void printStats() const {
+        if (ticks == 0) return;
+        std::cout << "Spatial audio: " << (double)sourceTicks / ticks << " sources and "
+                  << (double)occlusionRays / ticks << " occlusion rays per tick, "
+                  << (double)occlusionCulled / ticks << " outside the PVS box" << std::endl;
+    }
+};
+
+#endif // SPATIAL_AUDIO_H
@@ -0,0 +1,190 @@
+/**
+ * @file texture_utils.h
+ * @brief Image decoding and texture scaling shared by the game and maze_packer
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ */
+
+#ifndef TEXTURE_UTILS_H
+#define TEXTURE_UTILS_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Decode an image file into an ARGB8888 surface. The caller frees the
+ * surface. Returns nullptr (after logging) on failure.
+ */
+inline SDL_Surface* loadSurfaceARGB8888(const std::string& filename) {
+    SDL_Surface* surface = IMG_Load(filename.c_str());
+    if (!surface) {
+        std::cerr << "Failed to load image " << filename << ": " << IMG_GetError() << std::endl;
+        return nullptr;
+    }
+
+    // Convert surface to our desired format if needed
+    if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+        SDL_Surface* convertedSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(surface);
+        surface = convertedSurface;
+    }
+
+    if (!surface) {
+        std::cerr << "Failed to convert surface format for " << filename << std::endl;
+        return nullptr;
+    }
+    return surface;
+}
+
+/**
+ * Area (box) filter taps for one axis: destination sample i averages the
+ * source samples it covers, weighted by coverage.
+ */
+struct ResampleFilter {
+    std::vector<int> first;      // First source index per destination sample
+    std::vector<int> count;      // Number of taps per destination sample
+    std::vector<float> weights;  // count[i] weights per destination sample, concatenated
+
+    ResampleFilter(int srcSize, int dstSize) : first(dstSize), count(dstSize) {
+        double scale = double(srcSize) / dstSize;
+        for (int i = 0; i < dstSize; i++) {
+            double begin = i * scale;
+            double end = (i + 1) * scale;
+            int lo = (int)std::floor(begin);
+            int hi = std::min((int)std::ceil(end), srcSize);
+
+            first[i] = lo;
+            count[i] = hi - lo;
+            for (int j = lo; j < hi; j++) {
+                double coverage = std::min(end, j + 1.0) - std::max(begin, (double)j);
+                weights.push_back((float)(coverage / (end - begin)));
+            }
+        }
+    }
+};
+
+#ifdef __SSE2__
+inline __m128 unpackPixel(Uint32 pixel) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p = _mm_cvtsi32_si128((int)pixel);
+    p = _mm_unpacklo_epi8(p, zero);
+    p = _mm_unpacklo_epi16(p, zero);
+    return _mm_cvtepi32_ps(p);
+}
+
+inline Uint32 packPixel(__m128 channels) {
+    __m128i p = _mm_cvtps_epi32(channels);
+    p = _mm_packs_epi32(p, p);
+    p = _mm_packus_epi16(p, p);
+    return (Uint32)_mm_cvtsi128_si32(p);
+}
+#endif
+
+/**
+ * Resample ARGB8888 pixels to a destination size with an area filter, so
+ * large source art is averaged down instead of point-sampled. Channels are
+ * filtered independently (wall textures are opaque). srcPitch is in pixels;
+ * the destination is tightly packed.
+ */
+inline void resampleTexture(const Uint32* src, int srcWidth, int srcHeight, int srcPitch,
+                            Uint32* dst, int dstWidth, int dstHeight) {
+    ResampleFilter horizontal(srcWidth, dstWidth);
+    ResampleFilter vertical(srcHeight, dstHeight);
+
+    // Horizontal pass into four floats per pixel
+    std::vector<float> rows(srcHeight * dstWidth * 4);
+    for (int y = 0; y < srcHeight; y++) {
+        const Uint32* srcRow = src + y * srcPitch;
+        float* out = &rows[y * dstWidth * 4];
+        const float* weight = horizontal.weights.data();
+        for (int x = 0; x < dstWidth; x++) {
+            const Uint32* taps = srcRow + horizontal.first[x];
+            int count = horizontal.count[x];
+#ifdef __SSE2__
+            __m128 acc = _mm_setzero_ps();
+            for (int i = 0; i < count; i++) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(unpackPixel(taps[i]), _mm_set1_ps(weight[i])));
+            }
+            _mm_storeu_ps(out + x * 4, acc);
+#else
+            float acc[4] = {0, 0, 0, 0};
+            for (int i = 0; i < count; i++) {
+                for (int c = 0; c < 4; c++) {
+                    acc[c] += ((taps[i] >> (c * 8)) & 0xFF) * weight[i];
+                }
+            }
+            memcpy(out + x * 4, acc, sizeof(acc));
+#endif
+            weight += count;
+        }
+    }
+
+    // Vertical pass back to ARGB8888
+    const float* weight = vertical.weights.data();
+    for (int y = 0; y < dstHeight; y++) {
+        int first = vertical.first[y];
+        int count = vertical.count[y];
+        for (int x = 0; x < dstWidth; x++) {
+            const float* column = &rows[(first * dstWidth + x) * 4];
+#ifdef __SSE2__
+            __m128 acc = _mm_setzero_ps();
+            for (int i = 0; i < count; i++) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(column + i * dstWidth * 4), _mm_set1_ps(weight[i])));
+            }
+            dst[dstWidth * y + x] = packPixel(acc);
+#else
+            Uint32 pixel = 0;
+            for (int c = 0; c < 4; c++) {
+                float acc = 0.0f;
+                for (int i = 0; i < count; i++) {
+                    acc += column[i * dstWidth * 4 + c] * weight[i];
+                }
+                int value = (int)(acc + 0.5f);
+                pixel |= (Uint32)std::min(std::max(value, 0), 255) << (c * 8);
+            }
+            dst[dstWidth * y + x] = pixel;
+#endif
+        }
+        weight += count;
+    }
+}
+
+/**
+ * Pick the square, power-of-two size a wall texture is stored at: the
+ * largest power of two not above the source size, clamped to
+ * [minSize, maxSize]. Art at or below minSize keeps the base size.
+ */
+inline int chooseTextureSize(int srcWidth, int srcHeight, int minSize, int maxSize) {
+    int largest = std::max(srcWidth, srcHeight);
+    int size = minSize;
+    while (size * 2 <= largest && size * 2 <= maxSize) {
+        size *= 2;
+    }
+    return size;
+}
+
+/**
+ * Copy an ARGB8888 surface into a tightly packed pixel array.
+ */
+inline void copySurfacePixels(SDL_Surface* surface, Uint32* dst) {
+    SDL_LockSurface(surface);
+    const Uint8* row = (const Uint8*)surface->pixels;
+    for (int y = 0; y < surface->h; y++) {
+        memcpy(dst + y * surface->w, row, surface->w * sizeof(Uint32));
+        row += surface->pitch;
+    }
+    SDL_UnlockSurface(surface);
+}
+
+#endif // TEXTURE_UTILS_H
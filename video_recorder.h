@@ -0,0 +1,259 @@
+/**
+ * @file video_recorder.h
+ * @brief Raw Y4M video dump on a background writer thread
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The render loop copies each frame into a pooled buffer and returns; the
+ * writer thread converts ARGB8888 to 4:2:0 YUV (full range BT.601, SSE2)
+ * and appends it to the .y4m file. When every buffer is still queued the
+ * frame is dropped and counted instead of waiting for the disk.
+ */
+
+#ifndef VIDEO_RECORDER_H
+#define VIDEO_RECORDER_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "frame_pool.h"
+
+const int RECORDER_POOL_SIZE = 8;
+
+// Y = (77R + 150G + 29B) / 256
+inline Uint8 lumaFromPixel(Uint32 p) {
+    int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+    return (Uint8)((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+// Chroma from the sums of a 2x2 block's channels (each sum 0..1020)
+inline Uint8 clampChroma(int value) {
+    return (Uint8)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+inline Uint8 chromaU(int r, int g, int b) {
+    return clampChroma(((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128);
+}
+
+inline Uint8 chromaV(int r, int g, int b) {
+    return clampChroma(((128 * r - 107 * g - 21 * b + 512) >> 10) + 128);
+}
+
+/**
+ * Convert two ARGB8888 rows to two luma rows and one row of U and V.
+ * width must be even.
+ */
+inline void convertRowPairToI420(const Uint32* row0, const Uint32* row1, int width,
+                                 Uint8* y0, Uint8* y1, Uint8* u, Uint8* v) {
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i yR = _mm_set1_epi16(77), yG = _mm_set1_epi16(150), yB = _mm_set1_epi16(29);
+    const __m128i yRound = _mm_set1_epi16(128);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i uRG = _mm_set_epi16(-85, -43, -85, -43, -85, -43, -85, -43);
+    const __m128i vRG = _mm_set_epi16(-107, 128, -107, 128, -107, 128, -107, 128);
+    const __m128i uB = _mm_set_epi16(0, 128, 0, 128, 0, 128, 0, 128);
+    const __m128i vB = _mm_set_epi16(0, -21, 0, -21, 0, -21, 0, -21);
+    const __m128i chromaRound = _mm_set1_epi32(512);
+    const __m128i chromaOffset = _mm_set1_epi32(128);
+
+    for (; x + 8 <= width; x += 8) {
+        __m128i r[2], g[2], b[2];
+        const Uint32* rows[2] = {row0 + x, row1 + x};
+        Uint8* lumaRows[2] = {y0 + x, y1 + x};
+
+        for (int i = 0; i < 2; i++) {
+            __m128i lo = _mm_loadu_si128((const __m128i*)rows[i]);
+            __m128i hi = _mm_loadu_si128((const __m128i*)(rows[i] + 4));
+
+            // Split the eight pixels into 16-bit channel vectors
+            b[i] = _mm_packs_epi32(_mm_and_si128(lo, byteMask), _mm_and_si128(hi, byteMask));
+            g[i] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), byteMask),
+                                   _mm_and_si128(_mm_srli_epi32(hi, 8), byteMask));
+            r[i] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), byteMask),
+                                   _mm_and_si128(_mm_srli_epi32(hi, 16), byteMask));
+
+            // Sum stays below 65536, so unsigned 16-bit arithmetic is exact
+            __m128i luma = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r[i], yR), _mm_mullo_epi16(g[i], yG)),
+                                         _mm_add_epi16(_mm_mullo_epi16(b[i], yB), yRound));
+            luma = _mm_srli_epi16(luma, 8);
+            _mm_storel_epi64((__m128i*)lumaRows[i], _mm_packus_epi16(luma, luma));
+        }
+
+        // 2x2 block sums: add the rows, then adjacent pixels (as 32-bit)
+        __m128i rSum = _mm_madd_epi16(_mm_add_epi16(r[0], r[1]), ones);
+        __m128i gSum = _mm_madd_epi16(_mm_add_epi16(g[0], g[1]), ones);
+        __m128i bSum = _mm_madd_epi16(_mm_add_epi16(b[0], b[1]), ones);
+
+        __m128i rg = _mm_unpacklo_epi16(_mm_packs_epi32(rSum, rSum), _mm_packs_epi32(gSum, gSum));
+        __m128i b16 = _mm_packs_epi32(bSum, bSum);
+        __m128i bz = _mm_unpacklo_epi16(b16, _mm_setzero_si128());
+
+        __m128i uq = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rg, uRG), _mm_madd_epi16(bz, uB)), chromaRound);
+        __m128i vq = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rg, vRG), _mm_madd_epi16(bz, vB)), chromaRound);
+        uq = _mm_add_epi32(_mm_srai_epi32(uq, 10), chromaOffset);
+        vq = _mm_add_epi32(_mm_srai_epi32(vq, 10), chromaOffset);
+
+        __m128i uv = _mm_packs_epi32(uq, vq);
+        uv = _mm_packus_epi16(uv, uv);
+        int packedU = _mm_cvtsi128_si32(uv);
+        int packedV = _mm_cvtsi128_si32(_mm_srli_si128(uv, 4));
+        memcpy(u + x / 2, &packedU, 4);
+        memcpy(v + x / 2, &packedV, 4);
+    }
+#endif
+
+    for (; x < width; x += 2) {
+        Uint32 p[4] = {row0[x], row0[x + 1], row1[x], row1[x + 1]};
+        y0[x] = lumaFromPixel(p[0]);
+        y0[x + 1] = lumaFromPixel(p[1]);
+        y1[x] = lumaFromPixel(p[2]);
+        y1[x + 1] = lumaFromPixel(p[3]);
+
+        int r = 0, g = 0, b = 0;
+        for (int i = 0; i < 4; i++) {
+            r += (p[i] >> 16) & 0xFF;
+            g += (p[i] >> 8) & 0xFF;
+            b += p[i] & 0xFF;
+        }
+        u[x / 2] = chromaU(r, g, b);
+        v[x / 2] = chromaV(r, g, b);
+    }
+}
+
+inline void convertFrameToI420(const Uint32* pixels, int width, int height, Uint8* yuv) {
+    Uint8* yPlane = yuv;
+    Uint8* uPlane = yPlane + width * height;
+    Uint8* vPlane = uPlane + (width / 2) * (height / 2);
+    for (int y = 0; y < height; y += 2) {
+        convertRowPairToI420(pixels + y * width, pixels + (y + 1) * width, width,
+                             yPlane + y * width, yPlane + (y + 1) * width,
+                             uPlane + (y / 2) * (width / 2), vPlane + (y / 2) * (width / 2));
+    }
+}
+
+class VideoRecorder {
+private:
+    FramePool pool;
+    std::thread writer;
+    FILE* file;
+    int width;
+    int height;
+    std::atomic<Uint64> framesWritten;
+    std::atomic<Uint64> framesDropped;
+    std::atomic<bool> writeFailed;  // Set by the writer; later frames are dropped
+
+    void writerLoop() {
+        std::vector<Uint8> yuv(width * height * 3 / 2);
+        for (;;) {
+            int index = pool.waitReady();
+            if (index < 0) break;
+
+            if (writeFailed) {
+                pool.release(index);
+                framesDropped++;
+                continue;
+            }
+            convertFrameToI420(pool.buffer(index), width, height, yuv.data());
+            pool.release(index);
+
+            if (fputs("FRAME\n", file) == EOF || fwrite(yuv.data(), 1, yuv.size(), file) != yuv.size()) {
+                std::cerr << "Recording failed after " << framesWritten << " frames: " << strerror(errno) << std::endl;
+                writeFailed = true;
+                framesDropped++;
+                continue;
+            }
+            framesWritten++;
+        }
+    }
+
+public:
+    VideoRecorder() : file(nullptr), width(0), height(0), framesWritten(0), framesDropped(0), writeFailed(false) {}
+
+    ~VideoRecorder() {
+        stop();
+    }
+
+    /**
+     * Open a .y4m file and start the writer thread. Width and height must be
+     * even. frameRate is only written to the header; every submitted frame
+     * is stored.
+     */
+    bool start(const std::string& path, int frameWidth, int frameHeight, int frameRate) {
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Could not open " << path << " for recording" << std::endl;
+            return false;
+        }
+
+        width = frameWidth;
+        height = frameHeight;
+        // Full range, matching convertFrameToI420(); players assume limited range otherwise
+        if (fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+                    width, height, frameRate) < 0) {
+            std::cerr << "Could not write to " << path << ": " << strerror(errno) << std::endl;
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        framesWritten = 0;
+        framesDropped = 0;
+        writeFailed = false;
+
+        pool.allocate(RECORDER_POOL_SIZE, width * height);
+        writer = std::thread(&VideoRecorder::writerLoop, this);
+        return true;
+    }
+
+    bool isRecording() const {
+        return file != nullptr;
+    }
+
+    // Render thread: copy the frame out, or drop it if the writer is behind or has failed
+    void submitFrame(const Uint32* pixels) {
+        if (writeFailed) {
+            framesDropped++;
+            return;
+        }
+        int index = pool.tryAcquire();
+        if (index < 0) {
+            framesDropped++;
+            return;
+        }
+        memcpy(pool.buffer(index), pixels, width * height * sizeof(Uint32));
+        pool.submit(index);
+    }
+
+    Uint64 droppedFrames() const {
+        return framesDropped;
+    }
+
+    void stop() {
+        if (!file) return;
+
+        pool.close();
+        writer.join();
+        if (fclose(file) != 0 && !writeFailed) {
+            std::cerr << "Recording failed while closing: " << strerror(errno) << std::endl;
+            writeFailed = true;
+        }
+        file = nullptr;
+        std::cout << "Recording " << (writeFailed ? "incomplete: " : "finished: ") << framesWritten
+                  << " frames written, " << framesDropped << " dropped" << std::endl;
+    }
+};
+
+#endif // VIDEO_RECORDER_H
@@ -0,0 +1,427 @@
+/**
+ * @file voice_mixer.h
+ * @brief Fixed-pool sound effect mixer running after SDL_mixer's own mix
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * SDL_mixer allocates 8 channels and silently refuses new sounds once they
+ * are busy. VoiceMixer instead keeps VOICE_POOL_SIZE voices and mixes them
+ * into the device stream from a MIX_CHANNEL_POST effect, after SDL_mixer
+ * has mixed music and its channels. When every voice is busy, the least
+ * important one (lowest priority, then farthest, then closest to its end)
+ * is stolen if the new sound matters at least as much.
+ *
+ * The game thread never touches the pool: play/update/stop requests go
+ * through a single-producer single-consumer command queue that the audio
+ * thread drains at the start of each callback. Nothing on the audio thread
+ * allocates or locks. Samples are played straight out of Mix_Chunk buffers,
+ * which SDL_mixer has already converted to the device format; the mixer
+ * needs signed 16-bit stereo (MIX_DEFAULT_FORMAT with 2 channels).
+ */
+
+#ifndef VOICE_MIXER_H
+#define VOICE_MIXER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const int VOICE_POOL_SIZE = 256;
+const int VOICE_COMMAND_QUEUE_SIZE = 1024;    // Power of two
+const int VOICE_MAX_BUFFER_FRAMES = 16384;
+const int VOICE_GAIN_ONE = 32767;             // Q15 unity gain
+
+typedef Uint32 VoiceHandle;                   // 0 = none
+
+enum VoiceCommandType {
+    VOICE_PLAY,
+    VOICE_UPDATE,
+    VOICE_STOP
+};
+
+struct VoiceCommand {
+    VoiceCommandType type;
+    VoiceHandle handle;
+    const Sint16* samples;
+    Uint32 frames;
+    Sint16 gainLeft;
+    Sint16 gainRight;
+    Uint16 delayLeft;
+    Uint16 delayRight;
+    int priority;
+    float distance;
+};
+
+struct Voice {
+    VoiceHandle handle;       // 0 when the voice is free
+    const Sint16* samples;    // Interleaved stereo
+    Uint32 frames;
+    Uint32 position;
+    Sint16 gainLeft;
+    Sint16 gainRight;
+    Uint16 delayLeft;         // Frames each ear lags the source (interaural delay)
+    Uint16 delayRight;
+    int priority;
+    float distance;
+};
+
+/**
+ * Add count interleaved stereo frames, scaled by Q15 gains, into a 32-bit
+ * accumulator.
+ */
+inline void mixVoiceInto(Sint32* accum, const Sint16* samples, int count, Sint16 gainLeft, Sint16 gainRight) {
+    int i = 0;
+    int total = count * 2;
+#ifdef __SSE2__
+    const __m128i gains = _mm_set_epi16(gainRight, gainLeft, gainRight, gainLeft,
+                                        gainRight, gainLeft, gainRight, gainLeft);
+    for (; i + 8 <= total; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(samples + i));
+
+        // Full 32-bit products from the low and high halves
+        __m128i lo = _mm_mullo_epi16(s, gains);
+        __m128i hi = _mm_mulhi_epi16(s, gains);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+
+        __m128i* out = (__m128i*)(accum + i);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), p0));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), p1));
+    }
+#endif
+    for (; i < total; i += 2) {
+        accum[i] += (samples[i] * gainLeft) >> 15;
+        accum[i + 1] += (samples[i + 1] * gainRight) >> 15;
+    }
+}
+
+/**
+ * Scalar variant for voices with a per-ear delay: mixes count output frames
+ * starting at output frame position, reading each ear delay frames back.
+ */
+inline void mixVoiceDelayedInto(Sint32* accum, const Sint16* samples, Uint32 frames, Uint32 position, int count,
+                                Sint16 gainLeft, Sint16 gainRight, Uint16 delayLeft, Uint16 delayRight) {
+    for (int i = 0; i < count; i++) {
+        Uint32 t = position + i;
+        if (t >= delayLeft && t - delayLeft < frames) {
+            accum[i * 2] += (samples[(t - delayLeft) * 2] * gainLeft) >> 15;
+        }
+        if (t >= delayRight && t - delayRight < frames) {
+            accum[i * 2 + 1] += (samples[(t - delayRight) * 2 + 1] * gainRight) >> 15;
+        }
+    }
+}
+
+// stream += accum, saturated to 16 bits
+inline void resolveAccumulator(Sint16* stream, const Sint32* accum, int sampleCount) {
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 8 <= sampleCount; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(stream + i));
+        __m128i s0 = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i s1 = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        s0 = _mm_add_epi32(s0, _mm_loadu_si128((const __m128i*)(accum + i)));
+        s1 = _mm_add_epi32(s1, _mm_loadu_si128((const __m128i*)(accum + i + 4)));
+        _mm_storeu_si128((__m128i*)(stream + i), _mm_packs_epi32(s0, s1));
+    }
+#endif
+    for (; i < sampleCount; i++) {
+        Sint32 value = stream[i] + accum[i];
+        stream[i] = (Sint16)(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+    }
+}
+
+// Left/right Q15 gains for a mixer volume (0..128) and pan (-1 left .. 1 right)
+inline void panGains(int volume, float pan, Sint16& gainLeft, Sint16& gainRight) {
+    if (pan < -1.0f) pan = -1.0f;
+    if (pan > 1.0f) pan = 1.0f;
+    float base = VOICE_GAIN_ONE * (volume / (float)MIX_MAX_VOLUME);
+    gainLeft = (Sint16)(base * (pan > 0.0f ? 1.0f - pan : 1.0f));
+    gainRight = (Sint16)(base * (pan < 0.0f ? 1.0f + pan : 1.0f));
+}
+
+class VoiceMixer {
+private:
+    Voice voices[VOICE_POOL_SIZE];
+    std::vector<Sint32> accumulator;   // Sized once in attach()
+
+    // Commands: written by the game thread, read by the audio thread
+    VoiceCommand commands[VOICE_COMMAND_QUEUE_SIZE];
+    std::atomic<Uint32> commandHead;   // Next slot to write
+    std::atomic<Uint32> commandTail;   // Next slot to read
+    VoiceHandle nextHandle;
+
+    bool attached;
+    int frequency;
+    
+    // Optional audio-thread notification when a voice starts (for latency probes)
+    void (*startListener)(VoiceHandle, void*);
+    void* startListenerData;
+
+    // Statistics, written by the audio thread
+    std::atomic<Uint64> mixTicks;
+    std::atomic<Uint64> mixedFrames;
+    std::atomic<int> activeVoices;
+    std::atomic<int> peakVoices;
+    std::atomic<Uint32> stolenVoices;
+    std::atomic<Uint32> rejectedVoices;
+
+    bool push(const VoiceCommand& command) {
+        Uint32 head = commandHead.load(std::memory_order_relaxed);
+        if (head - commandTail.load(std::memory_order_acquire) >= (Uint32)VOICE_COMMAND_QUEUE_SIZE) {
+            return false;
+        }
+        commands[head & (VOICE_COMMAND_QUEUE_SIZE - 1)] = command;
+        commandHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    Voice* findVoice(VoiceHandle handle) {
+        for (int i = 0; i < VOICE_POOL_SIZE; i++) {
+            if (voices[i].handle == handle) return &voices[i];
+        }
+        return nullptr;
+    }
+
+    // true if a is a better voice to steal than b
+    static bool stealBefore(const Voice& a, const Voice& b) {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        if (a.distance != b.distance) return a.distance > b.distance;
+        return a.frames - a.position < b.frames - b.position;
+    }
+
+    void startVoice(const VoiceCommand& command) {
+        Voice* target = nullptr;
+        Voice* victim = nullptr;
+        for (int i = 0; i < VOICE_POOL_SIZE; i++) {
+            Voice& voice = voices[i];
+            if (voice.handle == 0) {
+                target = &voice;
+                break;
+            }
+            if (!victim || stealBefore(voice, *victim)) {
+                victim = &voice;
+            }
+        }
+        if (!target) {
+            if (command.priority < victim->priority ||
+                (command.priority == victim->priority && command.distance > victim->distance)) {
+                rejectedVoices++;
+                return;
+            }
+            target = victim;
+            stolenVoices++;
+        }
+
+        target->handle = command.handle;
+        target->samples = command.samples;
+        target->frames = command.frames;
+        target->position = 0;
+        target->gainLeft = command.gainLeft;
+        target->gainRight = command.gainRight;
+        target->delayLeft = command.delayLeft;
+        target->delayRight = command.delayRight;
+        target->priority = command.priority;
+        target->distance = command.distance;
+        if (startListener) {
+            startListener(command.handle, startListenerData);
+        }
+    }
+
+    void drainCommands() {
+        Uint32 tail = commandTail.load(std::memory_order_relaxed);
+        Uint32 head = commandHead.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            const VoiceCommand& command = commands[tail & (VOICE_COMMAND_QUEUE_SIZE - 1)];
+            if (command.type == VOICE_PLAY) {
+                startVoice(command);
+                continue;
+            }
+            Voice* voice = findVoice(command.handle);
+            if (!voice) continue;  // Already finished or stolen
+            if (command.type == VOICE_UPDATE) {
+                voice->gainLeft = command.gainLeft;
+                voice->gainRight = command.gainRight;
+                voice->delayLeft = command.delayLeft;
+                voice->delayRight = command.delayRight;
+                voice->distance = command.distance;
+            } else {
+                voice->handle = 0;
+            }
+        }
+        commandTail.store(tail, std::memory_order_release);
+    }
+
+    void mix(Sint16* stream, int frames) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        drainCommands();
+
+        // The accumulator was sized for the largest buffer we accept
+        if (frames > VOICE_MAX_BUFFER_FRAMES) frames = VOICE_MAX_BUFFER_FRAMES;
+        Sint32* accum = accumulator.data();
+        memset(accum, 0, frames * 2 * sizeof(Sint32));
+
+        int active = 0;
+        for (int i = 0; i < VOICE_POOL_SIZE; i++) {
+            Voice& voice = voices[i];
+            if (voice.handle == 0) continue;
+
+            // A delayed ear keeps playing after the other has finished
+            Uint32 length = voice.frames + (voice.delayLeft > voice.delayRight ? voice.delayLeft : voice.delayRight);
+            if (voice.position >= length) {
+                voice.handle = 0;
+                continue;
+            }
+
+            Uint32 remaining = length - voice.position;
+            int count = remaining < (Uint32)frames ? (int)remaining : frames;
+            if (voice.delayLeft == 0 && voice.delayRight == 0) {
+                mixVoiceInto(accum, voice.samples + voice.position * 2, count, voice.gainLeft, voice.gainRight);
+            } else {
+                mixVoiceDelayedInto(accum, voice.samples, voice.frames, voice.position, count,
+                                    voice.gainLeft, voice.gainRight, voice.delayLeft, voice.delayRight);
+            }
+            voice.position += count;
+            if (voice.position >= length) {
+                voice.handle = 0;
+            }
+            active++;
+        }
+        resolveAccumulator(stream, accum, frames * 2);
+
+        activeVoices = active;
+        if (active > peakVoices) peakVoices = active;
+        mixedFrames += frames;
+        mixTicks += SDL_GetPerformanceCounter() - start;
+    }
+
+    static void postEffect(int channel, void* stream, int len, void* udata) {
+        (void)channel;
+        ((VoiceMixer*)udata)->mix((Sint16*)stream, len / (2 * sizeof(Sint16)));
+    }
+
+public:
+    VoiceMixer() : commandHead(0), commandTail(0), nextHandle(1), attached(false), frequency(0),
+                   startListener(nullptr), startListenerData(nullptr),
+                   mixTicks(0), mixedFrames(0), activeVoices(0), peakVoices(0), stolenVoices(0), rejectedVoices(0) {
+        memset(voices, 0, sizeof(voices));
+    }
+
+    // listener runs on the audio thread and must not block
+    void setStartListener(void (*listener)(VoiceHandle, void*), void* udata) {
+        startListener = listener;
+        startListenerData = udata;
+    }
+    
+    /**
+     * Hook into the open audio device. Returns false (and leaves sounds to
+     * SDL_mixer's channels) unless the device is signed 16-bit stereo.
+     */
+    bool attach() {
+        Uint16 format;
+        int channels;
+        if (!Mix_QuerySpec(&frequency, &format, &channels) || format != AUDIO_S16SYS || channels != 2) {
+            std::cout << "Voice mixer needs 16-bit stereo audio - using SDL_mixer channels" << std::endl;
+            attached = false;
+            return false;
+        }
+        if (accumulator.empty()) {
+            accumulator.resize(VOICE_MAX_BUFFER_FRAMES * 2);
+        }
+        attached = Mix_RegisterEffect(MIX_CHANNEL_POST, postEffect, nullptr, this) != 0;
+        return attached;
+    }
+
+    /**
+     * Unhook and silence every voice. Must happen before any chunk that may
+     * still be playing is freed.
+     */
+    void detach() {
+        if (!attached) return;
+        Mix_UnregisterEffect(MIX_CHANNEL_POST, postEffect);
+        attached = false;
+
+        // The audio thread no longer runs mix(), so the pool is ours
+        memset(voices, 0, sizeof(voices));
+        commandTail.store(commandHead.load());
+    }
+
+    bool isAttached() const {
+        return attached;
+    }
+
+    /**
+     * Start chunk at volume (0..128) and pan (-1..1). Higher priority and
+     * smaller distance win when voices have to be stolen. Returns a handle
+     * for update()/stop(), or 0 if the request could not be queued.
+     */
+    VoiceHandle play(const Mix_Chunk* chunk, int volume, float pan = 0.0f, int priority = 0, float distance = 0.0f) {
+        if (!attached || !chunk) return 0;
+
+        VoiceCommand command;
+        command.type = VOICE_PLAY;
+        command.handle = nextHandle++;
+        if (nextHandle == 0) nextHandle = 1;
+        command.samples = (const Sint16*)chunk->abuf;
+        command.frames = chunk->alen / (2 * sizeof(Sint16));
+        panGains(volume, pan, command.gainLeft, command.gainRight);
+        command.delayLeft = 0;
+        command.delayRight = 0;
+        command.priority = priority;
+        command.distance = distance;
+        return push(command) ? command.handle : 0;
+    }
+
+    // New Q15 gains, per-ear delays (frames) and stealing distance for a playing voice
+    void update(VoiceHandle handle, Sint16 gainLeft, Sint16 gainRight, float distance,
+                Uint16 delayLeft = 0, Uint16 delayRight = 0) {
+        if (!attached || handle == 0) return;
+
+        VoiceCommand command;
+        memset(&command, 0, sizeof(command));
+        command.type = VOICE_UPDATE;
+        command.handle = handle;
+        command.gainLeft = gainLeft;
+        command.gainRight = gainRight;
+        command.delayLeft = delayLeft;
+        command.delayRight = delayRight;
+        command.distance = distance;
+        push(command);
+    }
+
+    void stop(VoiceHandle handle) {
+        if (!attached || handle == 0) return;
+
+        VoiceCommand command;
+        memset(&command, 0, sizeof(command));
+        command.type = VOICE_STOP;
+        command.handle = handle;
+        push(command);
+    }
+
+    int sampleRate() const {
+        return frequency;
+    }
+
+    int voicesPlaying() const {
+        return activeVoices;
+    }
+
+    void printStats() const {
+        if (mixedFrames == 0) return;
+        double mixSeconds = mixTicks / (double)SDL_GetPerformanceFrequency();
+        double audioSeconds = mixedFrames / (double)frequency;
+        std::cout << "Voice mixer: peak " << peakVoices << " voices, " << stolenVoices << " stolen, "
+                  << rejectedVoices << " rejected, " << 100.0 * mixSeconds / audioSeconds << "% of a core" << std::endl;
+    }
+};
+
+#endif // VOICE_MIXER_H
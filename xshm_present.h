@@ -0,0 +1,172 @@
+/**
+ * @file xshm_present.h
+ * @brief X11 MIT-SHM presentation backend (Linux, optional)
+ * @author Ahmed Dajani <adajani@iastate.edu>
+ * @date 2025
+ * @version 1.0
+ *
+ * The frame is rendered directly into an XImage that lives in a System V
+ * shared memory segment and is shown with XShmPutImage, so the X server
+ * reads the pixels straight from our buffer with no SDL_Renderer upload.
+ * Built only with -DMAZE_XSHM (make xshm); needs libX11 and libXext.
+ */
+
+#ifndef XSHM_PRESENT_H
+#define XSHM_PRESENT_H
+
+#include <SDL2/SDL.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <cstring>
+#include <iostream>
+
+class XShmPresenter {
+private:
+    Display* display;
+    Window window;
+    GC gc;
+    XImage* image;
+    XShmSegmentInfo shmInfo;
+    bool attached;
+    int width;
+    int height;
+
+    static bool& attachFailed() {
+        static bool failed = false;
+        return failed;
+    }
+
+    static int onAttachError(Display*, XErrorEvent*) {
+        attachFailed() = true;
+        return 0;
+    }
+
+public:
+    XShmPresenter() : display(nullptr), window(0), gc(0), image(nullptr), attached(false), width(0), height(0) {
+        memset(&shmInfo, 0, sizeof(shmInfo));
+        shmInfo.shmid = -1;
+        shmInfo.shmaddr = (char*)-1;
+    }
+
+    ~XShmPresenter() {
+        shutdown();
+    }
+
+    /**
+     * Set up a shared image for an existing X window. Fails (and cleans up)
+     * if MIT-SHM is unavailable, e.g. on a remote display, or if the window
+     * visual is not 32-bit xRGB, which the engine's ARGB8888 frame needs.
+     */
+    bool init(Display* targetDisplay, Window targetWindow, int frameWidth, int frameHeight) {
+        display = targetDisplay;
+        window = targetWindow;
+        width = frameWidth;
+        height = frameHeight;
+
+        if (!XShmQueryExtension(display)) {
+            std::cerr << "MIT-SHM extension not available" << std::endl;
+            return false;
+        }
+
+        XWindowAttributes attributes;
+        XGetWindowAttributes(display, window, &attributes);
+        Visual* visual = attributes.visual;
+        if ((attributes.depth != 24 && attributes.depth != 32) || visual->red_mask != 0xFF0000 ||
+            visual->green_mask != 0x00FF00 || visual->blue_mask != 0x0000FF) {
+            std::cerr << "MIT-SHM backend needs a 24/32-bit RGB visual" << std::endl;
+            return false;
+        }
+
+        image = XShmCreateImage(display, visual, attributes.depth, ZPixmap, nullptr, &shmInfo, width, height);
+        if (!image || image->bits_per_pixel != 32) {
+            std::cerr << "Failed to create a 32-bit shared XImage" << std::endl;
+            shutdown();
+            return false;
+        }
+
+        shmInfo.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+        if (shmInfo.shmid < 0) {
+            std::cerr << "shmget failed" << std::endl;
+            shutdown();
+            return false;
+        }
+
+        shmInfo.shmaddr = image->data = (char*)shmat(shmInfo.shmid, nullptr, 0);
+        if (shmInfo.shmaddr == (char*)-1) {
+            std::cerr << "shmat failed" << std::endl;
+            shutdown();
+            return false;
+        }
+        shmInfo.readOnly = False;
+
+        // XShmAttach reports failure asynchronously, so trap errors around a sync
+        attachFailed() = false;
+        int (*previousHandler)(Display*, XErrorEvent*) = XSetErrorHandler(onAttachError);
+        XShmAttach(display, &shmInfo);
+        XSync(display, False);
+        XSetErrorHandler(previousHandler);
+        if (attachFailed()) {
+            std::cerr << "XShmAttach failed (display is probably remote)" << std::endl;
+            shutdown();
+            return false;
+        }
+        attached = true;
+
+        // Mark for removal now; the segment lives until both sides detach
+        shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+
+        gc = XCreateGC(display, window, 0, nullptr);
+        return true;
+    }
+
+    void shutdown() {
+        if (!display) return;
+
+        if (attached) {
+            XShmDetach(display, &shmInfo);
+            XSync(display, False);
+            attached = false;
+        }
+        if (image) {
+            image->data = nullptr;  // Owned by the shared segment, not Xlib
+            XDestroyImage(image);
+            image = nullptr;
+        }
+        if (shmInfo.shmaddr != (char*)-1) {
+            shmdt(shmInfo.shmaddr);
+            shmInfo.shmaddr = (char*)-1;
+        }
+        if (shmInfo.shmid >= 0) {
+            shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+            shmInfo.shmid = -1;
+        }
+        if (gc) {
+            XFreeGC(display, gc);
+            gc = 0;
+        }
+        display = nullptr;
+    }
+
+    // Frame pixels (ARGB8888 layout); rows are pitch() pixels apart
+    Uint32* pixels() const {
+        return (Uint32*)image->data;
+    }
+
+    int pitch() const {
+        return image->bytes_per_line / 4;
+    }
+
+    /**
+     * Show the shared image. Waits until the server has read it, so the next
+     * frame can be written into the same memory without tearing.
+     */
+    void present() {
+        XShmPutImage(display, window, gc, image, 0, 0, 0, 0, width, height, False);
+        XSync(display, False);
+    }
+};
+
+#endif // XSHM_PRESENT_H